@@ -70,6 +70,7 @@ typedef struct {
   int initial_ubfs;         //initial ubfs
   int final_ubfs;           //final ubfs
   int cache_capacity;       //hash table capacity for the vtree
+  int huge_pages;           //backing of large tables: 0 base pages, 1 transparent, 2 explicit huge pages
 
   //flags
   BOOLEAN in_memory;     //whether or not to save nnf to file
@@ -77,6 +78,18 @@ typedef struct {
   BOOLEAN count_models;  //count the models of the output nnf
   BOOLEAN model_counter; //only (weighted) model counter
   BOOLEAN help;          //help
+
+  //preprocessing
+  BOOLEAN preprocess;    //simplify the cnf (keeping its model count) before compiling/counting
+  BOOLEAN probe;         //learn the units found by failed literal probing
+  BOOLEAN backbone;      //also learn the backbone literals (implies probe)
+  int backbone_conflicts; //clauses a backbone sat call may learn before it gives up (0: no limit)
+
+  //clause learning
+  int chrono_threshold;  //longest backjump in the backbone sat calls before backtracking chronologically (0: never)
+  int vivify_interval;   //learned clauses between two vivifications (0: never)
+  BOOLEAN trail_saving;  //replay the literals undone by backjumps when their decisions recur
+  char* learned_filename; //learned clauses loaded before and saved after compiling/counting
 } c2dOptions;
 
 /******************************************************************************
@@ -177,6 +177,82 @@ SatState* sat_state_new(const char* file_name);
 //frees the SatState
 void sat_state_free(SatState* sat_state);
 
+//sets the longest backjump (in decision levels) a learned clause may ask for
+//longer backjumps become chronological backtracks (threshold 0 always backjumps)
+void sat_set_chrono_threshold(c2dSize threshold, SatState* sat_state);
+
+//simplifies the cnf of sat state by unit propagation, subsumption, self-subsuming
+//strengthening and equivalent literal substitution, keeping its models
+//
+//a substituted variable is kept equivalent to its replacement by two binary clauses
+//if keep_equivalences is 1; otherwise it no longer appears in the cnf, so each such
+//variable doubles the model count (see sat_substituted_var_count())
+//
+//equivalent variables are replaced by the largest one if largest_repr is 1, by the
+//smallest one otherwise: the replacement takes over their clauses, so a vtree built
+//from an elimination order stays narrower when it is the variable eliminated last
+//
+//returns 0 if the cnf is found to be unsatisfiable (the sat state is then unchanged),
+//1 otherwise
+BOOLEAN sat_simplify(BOOLEAN keep_equivalences, BOOLEAN largest_repr, SatState* sat_state);
+
+//returns the number of variables that sat_simplify() dropped from the cnf
+c2dSize sat_substituted_var_count(const SatState* sat_state);
+
+//learns unit clauses for failed literals and literals implied by both decisions on
+//a variable, binary clauses for literals implied by a decision through longer
+//clauses, and then unit clauses for every backbone literal if backbone is 1 (the
+//models of the cnf do not change)
+//returns 0 if the cnf is found to be unsatisfiable, 1 otherwise
+BOOLEAN sat_probe(BOOLEAN backbone, SatState* sat_state);
+
+//returns the number of binary clauses learned by hyper-binary resolution in probing,
+//and the number of learned binary clauses removed by transitive reduction
+c2dSize sat_hyper_binary_count(const SatState* sat_state);
+c2dSize sat_reduced_binary_count(const SatState* sat_state);
+
+//a backbone query gives up after learning max_conflicts clauses (default 2, 0: no
+//limit), leaving its candidate out of the backbone; the candidates given up are counted
+void sat_set_backbone_conflicts(c2dSize max_conflicts, SatState* sat_state);
+c2dSize sat_backbone_gave_up_count(const SatState* sat_state);
+
+//vivifies the learned clauses at level 1 whenever interval more clauses have been
+//learned (interval 0, the default, never vivifies)
+void sat_set_vivify_interval(c2dSize interval, SatState* sat_state);
+
+//turns trail saving on (enable 1) or off (enable 0, the default): the literals undone
+//by a backjump are replayed from their reasons when their decision is made again
+void sat_set_trail_saving(BOOLEAN enable, SatState* sat_state);
+
+//returns the number of literals set from their saved reasons
+c2dSize sat_replayed_literal_count(const SatState* sat_state);
+
+//saves the learned clauses with at most max_size literals to a file, keyed by the cnf
+//returns the number of clauses saved
+c2dSize sat_save_learned_clauses(const char* file_name, c2dSize max_size, const SatState* sat_state);
+
+#ifdef SAT_ALLOC_CHECK
+//prints the number of decisions, assertions and undos, and the allocations they made
+//(libsat must be built with SAT_ALLOC_CHECK too)
+void sat_print_alloc_stats(void);
+#endif
+
+//adds the learned clauses saved to a file for the same cnf (if any), and checks them
+//with unit resolution, whose implications are then undone: the models of the cnf do
+//not change
+//returns 0 if unit resolution finds a contradiction, 1 otherwise
+BOOLEAN sat_load_learned_clauses(const char* file_name, SatState* sat_state);
+
+//sets how tables of 2 MB or more (the cache, trail nodes) are backed: 0 base pages,
+//1 transparent huge pages (the default), 2 huge pages reserved by the system
+void sat_set_huge_pages(int mode);
+
+//returns a zeroed table of size bytes, aligned to huge pages when it is large
+void* sat_large_alloc(size_t size);
+
+//frees a table returned by sat_large_alloc(size)
+void sat_large_free(void* table, size_t size);
+
 //applies unit resolution to the cnf of sat state
 //returns 1 if unit resolution succeeds, 0 if it finds a contradiction
 BOOLEAN sat_unit_resolution(SatState* sat_state);
@@ -39,7 +39,8 @@ void copy_key(register BYTE* key1, register BYTE* key2, register c2dSize size);
 VtreeCache* construct_vtree_cache(c2dSize capacity) {
   VtreeCache* cache = (VtreeCache*) malloc(sizeof(VtreeCache));
   
-  cache->buckets    = (VtreeCE**) calloc(capacity,sizeof(VtreeCE*));
+  //the table is large and probed at random: huge pages spare TLB misses
+  cache->buckets    = (VtreeCE**) sat_large_alloc(capacity*sizeof(VtreeCE*));
   cache->capacity   = capacity;
   cache->count      = 0;
   cache->memory     = 0;
@@ -64,7 +65,7 @@ void free_vtree_cache(VtreeCache* cache) {
     }
   }
   
-  free(cache->buckets); //free hash table
+  sat_large_free(cache->buckets,cache->capacity*sizeof(VtreeCE*)); //free hash table
   free(cache);
 }
 
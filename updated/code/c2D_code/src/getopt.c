@@ -20,12 +20,21 @@ const char* c2d_version();
 #define INITIAL_UBFS   25;
 #define FINAL_UBFS     25;
 #define CACHE_CAPACITY 20000003;
+#define HUGE_PAGES     1;
 
 #define IN_MEMORY    0;
 #define CHECK_ENTAIL 0;
 #define COUNT_MODELS 0;
 #define COUNTER      0;
 
+#define CHRONO_THRESHOLD 0;
+#define PREPROCESS       0;
+#define PROBE            0;
+#define BACKBONE         0;
+#define BACKBONE_CONFLICTS 2;
+#define VIVIFY_INTERVAL  0;
+#define TRAIL_SAVING     0;
+
 /******************************************************************************
  * c2d options 
  ******************************************************************************/
@@ -43,11 +52,20 @@ c2dOptions* init_options() {
   options->initial_ubfs       = INITIAL_UBFS;
   options->final_ubfs         = FINAL_UBFS;
   options->cache_capacity     = CACHE_CAPACITY;
+  options->huge_pages         = HUGE_PAGES;
   options->in_memory          = IN_MEMORY;
   options->check_entail       = CHECK_ENTAIL;
   options->count_models       = COUNT_MODELS;
   options->model_counter      = COUNTER;
   options->help               = 0;
+  options->chrono_threshold   = CHRONO_THRESHOLD;
+  options->preprocess         = PREPROCESS;
+  options->probe              = PROBE;
+  options->backbone           = BACKBONE;
+  options->backbone_conflicts = BACKBONE_CONFLICTS;
+  options->vivify_interval    = VIVIFY_INTERVAL;
+  options->trail_saving       = TRAIL_SAVING;
+  options->learned_filename   = NULL;
   return options;
 }
 
@@ -66,16 +84,25 @@ c2dOptions* get_options(int argc, char** argv) {
       {"initial_ubfs",   required_argument, 0, 'u'},
       {"final_ubfs",     required_argument, 0, 'f'},
       {"cache_capacity", required_argument, 0, 's'},
+      {"huge_pages",     required_argument, 0, 'H'},
       {"in_memory",      no_argument,       0, 'i'},
       {"check_entail",   no_argument,       0, 'E'},
       {"count_models",   no_argument,       0, 'C'},
       {"model_counter",  no_argument,       0, 'W'},
+      {"chrono",         required_argument, 0, 'B'},
+      {"preprocess",     no_argument,       0, 'P'},
+      {"probe",          no_argument,       0, 'F'},
+      {"backbone",       no_argument,       0, 'K'},
+      {"bb_conflicts",   required_argument, 0, 'Q'},
+      {"vivify",         required_argument, 0, 'V'},
+      {"trail",          no_argument,       0, 'T'},
+      {"learned",        required_argument, 0, 'L'},
       {"help",           no_argument,       0, 'h'},
       {0,                0,                 0,  0}
     };
 
     int index = 0;
-    int argument = getopt_long(argc,argv,"c:v:o:d:t:m:b:u:f:s:iECWh",long_options,&index);
+    int argument = getopt_long(argc,argv,"c:v:o:d:t:m:b:u:f:s:H:iECWB:PFKQ:V:TL:h",long_options,&index);
     if(argument==-1) break;
 
     switch(argument) {
@@ -89,10 +116,19 @@ c2dOptions* get_options(int argc, char** argv) {
       case 'u': options->initial_ubfs       = atoi(optarg);  break;
       case 'f': options->final_ubfs         = atoi(optarg);  break;
       case 's': options->cache_capacity     = atoi(optarg);  break;
+      case 'H': options->huge_pages         = atoi(optarg);  break;
       case 'i': options->in_memory          = 1;             break;
       case 'E': options->check_entail       = 1;             break;
       case 'C': options->count_models       = 1;             break;
       case 'W': options->model_counter      = 1;             break;
+      case 'B': options->chrono_threshold   = atoi(optarg);  break;
+      case 'P': options->preprocess         = 1;             break;
+      case 'F': options->probe              = 1;             break;
+      case 'K': options->backbone           = 1;             break;
+      case 'Q': options->backbone_conflicts = atoi(optarg);  break;
+      case 'V': options->vivify_interval    = atoi(optarg);  break;
+      case 'T': options->trail_saving       = 1;             break;
+      case 'L': options->learned_filename   = optarg;        break;
       case 'h': options->help               = 1;             break;
       default:  print_help(C2D_PACKAGE,1);
     }
@@ -134,6 +170,28 @@ c2dOptions* get_options(int argc, char** argv) {
     fprintf(stderr,"%s: option -s must be greater than 0\n",C2D_PACKAGE);
     print_help(C2D_PACKAGE,1);
   }
+  if(options->huge_pages < 0 || options->huge_pages > 2) {
+    fprintf(stderr,"%s: option -H must be 0, 1 or 2\n",C2D_PACKAGE);
+    print_help(C2D_PACKAGE,1);
+  }
+  if(options->chrono_threshold < 0) {
+    fprintf(stderr,"%s: option -B must not be negative\n",C2D_PACKAGE);
+    print_help(C2D_PACKAGE,1);
+  }
+  //counting and compiling need the trail in level order, which chronological
+  //backtracking does not keep: only the sat calls of the backbone may use it
+  if(options->chrono_threshold > 0 && options->backbone==0) {
+    fprintf(stderr,"%s: option -B needs option -K (counting and compiling always backjump)\n",C2D_PACKAGE);
+    print_help(C2D_PACKAGE,1);
+  }
+  if(options->backbone_conflicts < 0) {
+    fprintf(stderr,"%s: option -Q must not be negative\n",C2D_PACKAGE);
+    print_help(C2D_PACKAGE,1);
+  }
+  if(options->vivify_interval < 0) {
+    fprintf(stderr,"%s: option -V must not be negative\n",C2D_PACKAGE);
+    print_help(C2D_PACKAGE,1);
+  }
   return options;
 }
 
@@ -141,7 +199,7 @@ void print_help(const char* PACKAGE, int exit_value) {
   printf("%s: CNF to Decision-DNNF Compiler\n", PACKAGE);
   printf("%s\n",c2d_version());
 
-  printf("%s [-c .] [-v .] [-o .] [-d .] [-t .] [-m .] [-b .] [-u .] [-f .] [-s .]   [-i] [-E] [-C] [-W] [-h]\n", PACKAGE);
+  printf("%s [-c .] [-v .] [-o .] [-d .] [-t .] [-m .] [-b .] [-u .] [-f .] [-s .]   [-i] [-E] [-C] [-W] [-B .] [-P] [-F] [-K] [-Q .] [-V .] [-T] [-L .] [-H .] [-h]\n", PACKAGE);
    
 
   printf("  --cnf             -c FILE    set input CNF file\n");
@@ -166,11 +224,20 @@ void print_help(const char* PACKAGE, int exit_value) {
   printf("  --final_ubfs      -f FACTOR  set end balance factor when using   option -m 1 (default 25, must be between 1 and 49, inclusive)\n");
 
   printf("  --cache_capacity  -s SIZE    set the hash table capacity for the vtree\n");
+  printf("  --huge_pages      -H MODE    back the cache and the trail with 0: base pages, 1: transparent huge pages (default), 2: huge pages reserved by the system (or transparent ones if none is free)\n");
 
   printf("  --in_memory       -i         suppress the saving of compiled NNF to a file\n");
   printf("  --check_entail    -E         verify the compiled Decision-DNNF is correct by ensuring it is decomposable and also entails the input CNF\n");
   printf("  --count_models    -C         count the models of the input CNF after compiling it into a Decision-DNNF\n");
   printf("  --model_counter   -W         count the (weighted) models of the input CNF without compiling it into a Decision-DNNF\n");
+  printf("  --chrono          -B LEVELS  in the sat calls of option -K, backtrack chronologically instead of backjumping over more than LEVELS levels (default 0: always backjump; counting and compiling always backjump)\n");
+  printf("  --preprocess      -P         simplify the input CNF first, keeping its model count (by unit propagation, subsumption, strengthening and equivalent literal substitution)\n");
+  printf("  --probe           -F         fix failed literals and literals implied by both values of a variable before compiling/counting\n");
+  printf("  --backbone        -K         also fix the literals that hold in every model (backbone), with one sat call per candidate (which gives up as set by -Q)\n");
+  printf("  --bb_conflicts    -Q COUNT   give up the sat call of a backbone candidate after COUNT learned clauses, leaving it out of the backbone (default 2, 0: never give up)\n");
+  printf("  --vivify          -V COUNT   shorten the learned clauses by vivification each time COUNT more are learned (default 0: never)\n");
+  printf("  --trail           -T         save the literals undone by backjumps, and replay them when their decisions are made again\n");
+  printf("  --learned         -L FILE    start with the learned clauses saved to FILE for the same CNF (if any), and save the short learned clauses to FILE when done\n");
   printf("  --help            -h         print this help and exit\n");
   exit(exit_value);
 }
@@ -19,6 +19,18 @@ void pprint_bytes(const char* string, c2dSize bytes);
 char* extended_file_name(const char* fname, const char* new_extension);
 const char* vtree_type(const c2dOptions* options);
 
+//learned clauses with more literals are not saved (option -L)
+#define SAVED_CLAUSE_MAX_SIZE 12
+
+//saves the short learned clauses to the file of option -L, if any
+static void save_learned(const c2dOptions* options, const SatState* sat_state) {
+  if(options->learned_filename==NULL) return;
+  printf("\nSaving learned clauses...");
+  c2dSize count = sat_save_learned_clauses(options->learned_filename,SAVED_CLAUSE_MAX_SIZE,sat_state);
+  printf(" DONE");
+  printf("\n  Saved clauses\t%"PRIvS"",count);
+}
+
 /******************************************************************************
  * start
  ******************************************************************************/
@@ -36,9 +48,60 @@ int main(int argc, char* argv[]) {
   //construct CNF 
   start_total_t = start_t = clock();
   printf("\nConstructing CNF...");
+  sat_set_huge_pages(options->huge_pages);
   sat_state = sat_state_new(options->cnf_filename);
+  sat_set_vivify_interval(options->vivify_interval,sat_state);
+  sat_set_trail_saving(options->trail_saving,sat_state);
   clock_t sat_t = clock()-start_t;
   printf(" DONE");
+
+  //simplify CNF: when compiling, substituted variables keep their equivalences
+  //so that the Decision-DNNF has the models of the input CNF; the natural
+  //elimination order (-m 2) eliminates small variables first, so equivalent
+  //variables are then replaced by the largest one (the smallest one otherwise)
+  if(options->preprocess) {
+    printf("\nSimplifying CNF..."); fflush(stdout);
+    c2dSize var_count    = sat_var_count(sat_state);
+    c2dSize clause_count = sat_clause_count(sat_state);
+    start_t = clock();
+    BOOLEAN consistent = sat_simplify(options->model_counter==0,options->vtree_method==2,sat_state);
+    clock_t simplify_t = clock()-start_t;
+    printf(" DONE");
+    if(!consistent) printf("\n  CNF is inconsistent");
+    printf("\n  Vars=%"PRIvS" / Clauses=%"PRIvS" before",var_count,clause_count);
+    printf("\n  Substituted vars\t%"PRIvS"",sat_substituted_var_count(sat_state));
+    printf("\n  Simplify Time\t%0.3fs",((double)(simplify_t))/CLOCKS_PER_SEC);
+  }
+
+  //warm start: the clauses saved for this cnf follow from it, so they keep its
+  //models (clauses over variables dropped by simplification are skipped)
+  if(options->learned_filename!=NULL) {
+    printf("\nLoading learned clauses..."); fflush(stdout);
+    BOOLEAN consistent = sat_load_learned_clauses(options->learned_filename,sat_state);
+    printf(" DONE");
+    if(!consistent) printf("\n  CNF is inconsistent");
+    printf("\n  Learned clauses\t%"PRIvS"",sat_learned_clause_count(sat_state));
+  }
+
+  //probe: the units found are learned, so they hold at level 1 from now on
+  if(options->probe || options->backbone) {
+    printf("\nProbing..."); fflush(stdout);
+    start_t = clock();
+    //chronological backtracking (-B) is for the sat calls of the backbone only:
+    //counting and compiling need the trail in level order, which it does not keep
+    sat_set_chrono_threshold(options->chrono_threshold,sat_state);
+    sat_set_backbone_conflicts(options->backbone_conflicts,sat_state);
+    BOOLEAN consistent = sat_probe(options->backbone,sat_state);
+    sat_set_chrono_threshold(0,sat_state);
+    clock_t probe_t = clock()-start_t;
+    printf(" DONE");
+    if(!consistent) printf("\n  CNF is inconsistent");
+    printf("\n  Learned clauses\t%"PRIvS"",sat_learned_clause_count(sat_state));
+    printf("\n  Binary clauses\t%"PRIvS" added, %"PRIvS" removed",
+           sat_hyper_binary_count(sat_state),sat_reduced_binary_count(sat_state));
+    if(options->backbone) printf("\n  Backbone candidates given up\t%"PRIvS"",sat_backbone_gave_up_count(sat_state));
+    printf("\n  Probe Time\t%0.3fs",((double)(probe_t))/CLOCKS_PER_SEC);
+  }
   printf("\nCNF stats: ");
   printf("\n  Vars=%"PRIvS" / ",sat_var_count(sat_state));
   printf("Clauses=%"PRIvS"",sat_clause_count(sat_state));
@@ -71,13 +134,21 @@ int main(int argc, char* argv[]) {
     start_t = clock();
     printf("\nCounting..."); fflush(stdout);
     c2dWmc count = count_vtree(manager,sat_state);
+    //each substituted variable is free in the simplified CNF, but fixed by its
+    //replacement in the input CNF
+    for(c2dSize i=0; i<sat_substituted_var_count(sat_state); i++) count /= 2;
     clock_t count_t = clock()-start_t;
     printf(" DONE");
     printf("\n  Learned clauses      \t%"PRIvS"",sat_learned_clause_count(sat_state));
+    if(options->trail_saving) printf("\n  Replayed literals    \t%"PRIvS"",sat_replayed_literal_count(sat_state));
     print_vtree_cache_stats(manager->cache);
+#ifdef SAT_ALLOC_CHECK
+    sat_print_alloc_stats();
+#endif
     printf("\nCount stats:");
     printf("\n  Count Time\t%0.3fs",((double)(count_t))/CLOCKS_PER_SEC);
     printf("\n  Count \t%0.3"PRIwmcS"",count);
+    save_learned(options,sat_state);
     printf("\nTotal Time: %0.3fs\n\n",((double)clock()-start_total_t)/CLOCKS_PER_SEC);
     free(options);
     vtree_manager_free(manager);
@@ -93,8 +164,13 @@ int main(int argc, char* argv[]) {
   printf(" DONE");
   pprint_bytes("\n  NNF memory      \t",nnf_manager_memory(nnf_manager));
   printf("\n  Learned clauses      \t%"PRIvS"",sat_learned_clause_count(sat_state));
+  if(options->trail_saving) printf("\n  Replayed literals    \t%"PRIvS"",sat_replayed_literal_count(sat_state));
   print_vtree_cache_stats(manager->cache);
+#ifdef SAT_ALLOC_CHECK
+  sat_print_alloc_stats();
+#endif
   printf("\n  Compile Time\t%0.3fs",((double)(comp_t))/CLOCKS_PER_SEC);
+  save_learned(options,sat_state);
 	
   char* nnf_fname = extended_file_name(options->cnf_filename,".nnf");
 
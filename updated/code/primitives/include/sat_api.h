@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
 #include <time.h>
 
 /******************************************************************************
@@ -39,8 +41,60 @@ typedef unsigned long c2dSize;  //for variables, clauses, and various things
 typedef signed long c2dLiteral; //for literals
 typedef double c2dWmc;          //for (weighted) model count
 
+//indices and counts stored in variables, literals and clauses: 32 bits in a library
+//built with make COMPACT=1 (SAT_COMPACT_INDEX), which takes cnfs of less than 2^31
+//variables and clauses and keeps these structures smaller in the cache; the functions
+//below take and return c2dSize and c2dLiteral either way
+#ifdef SAT_COMPACT_INDEX
+typedef uint32_t c2dIndex;
+typedef int32_t c2dLitIndex;
+#define C2D_INDEX_MAX INT32_MAX
+#else
+typedef c2dSize c2dIndex;
+typedef c2dLiteral c2dLitIndex;
+#define C2D_INDEX_MAX LONG_MAX
+#endif
+
 
 #define BUF_LEN 32768
+#define BACKBONE_MAX_CONFLICTS 2 //clauses a backbone query may learn by default before it gives up
+
+/******************************************************************************
+ * Allocation checks
+ *
+ * Built with -DSAT_ALLOC_CHECK (make ALLOC_CHECK=1), the library counts its
+ * allocations, and aborts when deciding a literal, asserting a clause (up to
+ * unit resolution) or undoing decisions allocates anything but:
+ * --growth of a buffer that the sat state keeps and reuses (trail nodes, the
+ *   implied_by arrays of literals, conflict analysis scratch, occurrence lists,
+ *   the saved trail), which stops once the search has warmed up
+ * --the clause learned from a contradiction
+ * A sat state writing a DRAT proof is not checked. The counts are global, so the
+ * checks are meant for single-threaded runs.
+ ******************************************************************************/
+
+#ifdef SAT_ALLOC_CHECK
+enum { ALLOC_DECIDE, ALLOC_ASSERT, ALLOC_UNDO, ALLOC_OPS };
+
+typedef struct {
+    unsigned long allocs;             //calls to malloc, calloc and realloc
+    unsigned long growths;            //of them, those growing a buffer that is reused
+    unsigned long ops[ALLOC_OPS];     //decisions, assertions and undos
+    unsigned long op_allocs[ALLOC_OPS]; //allocations they made, growths and learned clauses apart
+} AllocStats;
+
+extern AllocStats sat_alloc_stats;
+void* alloc_counted(void* ptr);
+#define malloc(size) alloc_counted(malloc(size))
+#define calloc(count, size) alloc_counted(calloc(count, size))
+#define realloc(ptr, size) alloc_counted(realloc(ptr, size))
+#define ALLOC_GROWTH(count) (sat_alloc_stats.growths += (count))
+
+//prints the number of operations of each kind, and the allocations they made
+void sat_print_alloc_stats(void);
+#else
+#define ALLOC_GROWTH(count)
+#endif
 
 /******************************************************************************
  * Basic structures
@@ -50,20 +104,28 @@ typedef double c2dWmc;          //for (weighted) model count
  * Variables:
  * --You must represent variables using the following struct 
  * --Variable index must start at 1, and is no greater than the number of cnf variables
- * --Index of a variable must be of type "c2dSize"
+ * --Index of a variable must be of type "c2dIndex" (c2dSize unless built compact)
  * --The field "mark" below and its related functions should not be changed
  ******************************************************************************/
 
 typedef struct literal Lit;
 typedef struct clause Clause;
+typedef struct xor_matrix XorMatrix;
+typedef struct card_set CardSet;
+typedef struct elim_stack ElimStack;
+typedef struct proof Proof;
+typedef struct saved_trail SavedTrail;
+typedef struct formula Formula;
+typedef struct node_slab NodeSlab;
 
 typedef struct var {
-    c2dSize index;
+    c2dIndex index;
     Lit* pos_literal;
     Lit* neg_literal;
     Clause** clauses;
-    c2dSize n_clauses;
-    c2dSize clauses_buf_len;
+    c2dIndex n_clauses;
+    c2dIndex clauses_buf_len;
+    BOOLEAN phase;                  // saved phase: 1 for positive, 0 for negative
     BOOLEAN mark; //THIS FIELD MUST STAY AS IS
 } Var;
 
@@ -75,17 +137,19 @@ void Var_delete(Var* var);
  * --You must represent literals using the following struct 
  * --Positive literals' indices range from 1 to n (n is the number of cnf variables)
  * --Negative literals' indices range from -n to -1 (n is the number of cnf variables)
- * --Index of a literal must be of type "c2dLiteral"
+ * --Index of a literal must be of type "c2dLitIndex" (c2dLiteral unless built compact)
  ******************************************************************************/
 
 struct literal {
-    c2dLiteral index;
-    c2dSize decision_level;
+    c2dLitIndex index;
+    c2dIndex decision_level;
     Lit** implied_by;
-    c2dSize n_implied_by;
+    c2dIndex n_implied_by;
+    c2dIndex implied_by_buf_len;    // implied_by is kept when the literal is undone
+    Clause* reason;                 // clause that implied the literal (NULL if none)
     Clause** clauses;
-    c2dSize n_clauses;
-    c2dSize clauses_buf_len;
+    c2dIndex n_clauses;
+    c2dIndex clauses_buf_len;
     Var* var;
 };
 
@@ -97,6 +161,7 @@ struct LitNode {
     Lit* literal;
     LitNode* next;
     LitNode* prev;
+    LitNode* trail;                 // decisions: the last implied literal when decided
 };
 
 LitNode* LitNode_new(Lit* literal, LitNode* prev, LitNode* next);
@@ -106,21 +171,22 @@ void LitNode_delete(LitNode* node);
  * Clauses: 
  * --You must represent clauses using the following struct 
  * --Clause index must start at 1, and is no greater than the number of cnf clauses
- * --Index of a clause must be of type "c2dSize"
+ * --Index of a clause must be of type "c2dIndex" (c2dSize unless built compact)
  * --A clause must have an array consisting of its literals
  * --The index of literal array must start at 0, and is less than the clause size
  * --The field "mark" below and its related functions should not be changed
  ******************************************************************************/
 
 struct clause {
-    c2dSize index;
+    c2dIndex index;
     Lit** literals;
-    c2dSize n_literals;
-    c2dSize subsumed_level;
-    c2dSize assertion_level;
-    c2dLiteral n_false;
+    c2dIndex n_literals;
+    c2dIndex subsumed_level;
+    c2dIndex assertion_level;
+    c2dLitIndex n_false;
     Lit* watch_lit1;
     Lit* watch_lit2;
+    BOOLEAN detached;               // replaced by a cardinality constraint in propagation
     BOOLEAN mark; //THIS FIELD MUST STAY AS IS
 };
 
@@ -147,7 +213,37 @@ typedef struct sat_state_t {
     LitNode* decided_literals;
     LitNode* implied_literals;
     Clause* asserted_clause;
+    Clause* empty_clause;           // learned when unit resolution fails at level 1
     BOOLEAN from_decision;
+    Lit** failed_assumptions;       // assumptions of the last unsatisfiable query
+    c2dSize n_failed_assumptions;
+    BOOLEAN assumption_failed;
+    c2dSize query_conflicts;        // clauses the current query may still learn (0: no limit)
+    BOOLEAN query_gave_up;          // set when the current query runs out of them
+    BOOLEAN* model;                 // model[i] is the value of variable i in the last model
+    XorMatrix* xor_matrix;          // XOR constraints recovered from the cnf (or NULL)
+    CardSet* card_set;              // at-most-k constraints recovered from the cnf (or NULL)
+    c2dSize chrono_threshold;       // longest backjump before backtracking chronologically (0: never)
+    c2dSize vivify_interval;        // learned clauses between two vivifications (0: never)
+    c2dSize n_vivified;             // learned clauses already considered for vivification
+    ElimStack* elim_stack;          // clauses removed by variable elimination (or NULL)
+    c2dSize n_substituted;          // variables sat_simplify() dropped from the cnf
+    c2dSize n_hyper_binaries;       // binary clauses learned by hyper-binary resolution in probing
+    c2dSize n_reduced_binaries;     // learned binary clauses removed by transitive reduction
+    c2dSize backbone_conflicts;     // clauses a backbone query may learn before it gives up (0: no limit)
+    c2dSize n_backbone_gave_up;     // backbone candidates whose query gave up
+    Proof* proof;                   // DRAT proof being written (or NULL)
+    BOOLEAN vivifying;              // learned clauses must not change in conflict analysis
+    SavedTrail* saved_trail;        // levels undone by the last backjump (or NULL)
+    Formula* formula;               // its cnf before the first change (NULL until then, see formula_capture())
+    BOOLEAN extended;               // clauses not following from the formula were added
+    LitNode* free_nodes;            // trail nodes undone, reused by later decisions and implications
+    NodeSlab* node_slabs;           // the blocks the trail nodes are carved from
+    BOOLEAN* seen;                  // conflict analysis: literals met (all 0 between analyses)
+    Lit** marked_lits;              // conflict analysis: the literals marked in seen
+    Lit** analysis_lits;            // conflict analysis: literals of the clause being learned
+    Clause** resolved;              // conflict analysis: learned clauses resolved
+    c2dSize analysis_n;             // number of variables the analysis arrays are sized for
 } SatState;
 
 /******************************************************************************
@@ -205,6 +301,9 @@ Lit* sat_index2literal(c2dLiteral index, const SatState* sat_state);
 //returns the index of a literal
 c2dLiteral sat_literal_index(const Lit* lit);
 
+//returns the complement of a literal
+Lit* sat_literal_complement(const Lit* lit);
+
 //returns the positive literal of a variable
 Lit* sat_pos_literal(const Var* var);
 
@@ -215,14 +314,38 @@ Lit* sat_neg_literal(const Var* var);
 //a literal is implied by deciding its variable, or by inference using unit resolution
 BOOLEAN sat_implied_literal(const Lit* lit);
 
+//returns the literal of a variable that agrees with its saved phase
+//the phase of a variable is saved when it is un-instantiated, or seeded by local search
+Lit* sat_phase_literal(const Var* var);
+
 
 //sets the literal to true, and then runs unit resolution
 //returns a learned clause if unit resolution detected a contradiction, NULL otherwise
 Clause* sat_decide_literal(Lit* lit, SatState* sat_state);
 
+//sets the literals lits[0..k-1] (a cube over distinct variables) to true, each at
+//a new decision level in turn, skipping the literals already true, and then runs
+//unit resolution once for all of them
+//returns a learned clause if unit resolution detected a contradiction, NULL otherwise
+//
+//a literal implied gets the level of the latest decision it depends on, so assertion
+//levels are those of deciding the literals one at a time (a literal of the cube that
+//the ones before it would imply is decided all the same)
+//
+//if a literal of the cube is already false, it is the contradiction: no level is
+//opened, and the clause returned is the reason of its complement (the complement of
+//a decision is not allowed, as no clause explains it)
+Clause* sat_decide_literals(Lit** lits, c2dSize k, SatState* sat_state);
+
 //undoes the last literal decision and the corresponding implications obtained by unit resolution
 void sat_undo_decide_literal(SatState* sat_state);
 
+//undoes the decisions above level, and the implications obtained by unit resolution at
+//those levels, in a single pass over the literals they set (level is at least 1)
+//
+//this is the same as calling sat_undo_decide_literal() once per level, only faster
+void sat_undo_to_level(c2dSize level, SatState* sat_state);
+
 /******************************************************************************
  * Clauses 
  ******************************************************************************/
@@ -265,7 +388,89 @@ SatState* sat_state_new(const char* file_name);
 //frees the SatState
 void sat_state_free(SatState* sat_state);
 
+//the cnf of a file, or the cnf of a SatState before it is first changed, as literal
+//indices (see formula.c); it is what sat_state_reset() goes back to, and what the
+//learned clauses saved to a file are keyed by
+//
+//reads an input cnf file into a formula (returns NULL if the file cannot be opened)
+Formula* formula_read(const char* file_name);
+
+//holds one more reference to a formula, and releases one (it is freed with the last)
+Formula* formula_retain(Formula* formula);
+void formula_release(Formula* formula);
+
+//returns the number of variables and of clauses of a formula
+c2dSize formula_var_count(const Formula* formula);
+c2dSize formula_clause_count(const Formula* formula);
+
+//returns the literals of the index^th clause of a formula, and their number in size
+//index starts from 0, and is less than the number of clauses of the formula
+const c2dLiteral* formula_clause(c2dSize index, c2dSize* size, const Formula* formula);
+
+//returns a 64-bit hash of the clauses of a formula, in order
+unsigned long long formula_hash(const Formula* formula);
+
+//returns a reference to the formula of sat state (read from its cnf clauses if it holds
+//none), to be released with formula_release()
+Formula* formula_of_state(const SatState* sat_state);
+
+//makes sure sat state holds its formula, before its cnf is changed
+void formula_capture(SatState* sat_state);
+
+//returns a copy of the SatState, with the same setting and learned clauses, built
+//from memory (the cnf file is not read again)
+//
+//this copies the cnf clauses too, so it takes time and memory linear in the size of
+//the cnf and of the learned clauses; it only saves reading and parsing the file
+//
+//the copy shares nothing with the SatState but their formula (if any), so each can be
+//used on its own thread (no DRAT proof is written for the copy, and no trail is saved
+//for it yet)
+SatState* sat_state_clone(const SatState* sat_state);
+
+//returns the SatState to its condition right after construction: no literal is set,
+//the cnf is the one of its formula again (undoing preprocessing and symmetry breaking),
+//and the learned clauses are kept if keep_learned is 1, dropped otherwise
+//
+//learned clauses follow from the cnf, so keeping them changes no answer (they are
+//dropped anyway after symmetry breaking or sat_add_clause()); the settings (chrono
+//threshold, vivify interval, trail saving, backbone conflicts) are kept, and a DRAT
+//proof being written is closed
+//
+//preprocessing and symmetry breaking need a SatState without learned clauses
+void sat_state_reset(BOOLEAN keep_learned, SatState* sat_state);
+
+//sets the longest backjump (in decision levels) a learned clause may ask for
+//
+//when the assertion level of a learned clause is more than threshold levels below the
+//level of its conflict, the clause asks instead for backtracking a single level: it is
+//asserted right below the conflict level, and the literal it implies is placed at the
+//assertion level (literals are then out of order in the trail)
+//
+//threshold 0 (the default) always backjumps to the assertion level
+void sat_set_chrono_threshold(c2dSize threshold, SatState* sat_state);
+
+//vivifies the learned clauses at level 1 whenever interval more clauses have been
+//learned (interval 0, the default, never vivifies)
+void sat_set_vivify_interval(c2dSize interval, SatState* sat_state);
+
+//shortens or removes the clauses learned since the last call, by deciding the
+//negations of their literals one at a time (the models of the cnf do not change)
+//
+//this is called at decision level 1, after unit resolution succeeded
+//returns 0 if unit resolution then finds a contradiction, 1 otherwise
+BOOLEAN sat_vivify(SatState* sat_state);
+
 Clause * unit_resolution_helper(Lit * lit, SatState * sat_state);
+void imply_literal(Lit* unset_lit, Clause* clause, SatState* sat_state);
+Clause* construct_asserted_clause(Clause* clause, SatState* sat_state);
+
+//removes the learned clauses, renumbering the others
+void remove_learned(Clause** clauses, c2dSize count, SatState* sat_state);
+
+//adds a clause with the given literals to the learned clauses, without running
+//unit resolution
+void append_learned(Lit** literals, c2dSize size, SatState* sat_state);
 
 //applies unit resolution to the cnf of sat state
 //returns 1 if unit resolution succeeds, 0 if it finds a contradiction
@@ -282,6 +487,329 @@ void sat_undo_unit_resolution(SatState* sat_state);
 //it is used to decide whether the sat state is at the right decision level for adding clause.
 BOOLEAN sat_at_assertion_level(const Clause* clause, const SatState* sat_state);
 
+/******************************************************************************
+ * Incremental solving under assumptions
+ ******************************************************************************/
+
+//checks the satisfiability of the cnf together with the assumption literals lits[0..k-1]
+//returns 1 if satisfiable, 0 otherwise
+//
+//learned clauses are kept in the sat state between calls, and the sat state is back at
+//decision level 1 (with nothing implied) when the call returns
+BOOLEAN sat_solve_assuming(Lit** lits, c2dSize k, SatState* sat_state);
+
+//as sat_solve_assuming(), but gives up once the query has learned max_conflicts
+//clauses (0 for no limit)
+//returns 1 if satisfiable, 0 if not, and -1 if it gave up (no model is saved then)
+int sat_solve_assuming_bounded(Lit** lits, c2dSize k, c2dSize max_conflicts, SatState* sat_state);
+
+//returns the assumptions of the last unsatisfiable sat_solve_assuming() call that
+//are responsible for unsatisfiability (empty when the cnf itself is unsatisfiable)
+Lit** sat_failed_assumptions(c2dSize* count, const SatState* sat_state);
+
+//returns 1 if the literal is true in the model found by the last satisfiable
+//sat_solve_assuming() or sat_local_search() call (or saved by sat_save_model()),
+//0 otherwise
+BOOLEAN sat_model_literal(const Lit* lit, const SatState* sat_state);
+
+//saves the current setting of sat state, in which all variables are instantiated,
+//as the model
+void sat_save_model(SatState* sat_state);
+
+/******************************************************************************
+ * Stochastic local search
+ ******************************************************************************/
+
+//runs a probSAT local search over the cnf clauses for at most max_flips flips
+//literals implied in the current setting of sat state are never flipped
+//returns 1 if a model is found (see sat_model_literal()), 0 otherwise
+//
+//in both cases, the saved phases of variables are set to the best assignment found
+BOOLEAN sat_local_search(c2dSize max_flips, unsigned long seed, SatState* sat_state);
+
+/******************************************************************************
+ * XOR constraints
+ ******************************************************************************/
+
+//recovers the XOR constraints encoded by groups of cnf clauses (NULL if there are none)
+XorMatrix* xor_matrix_new(SatState* sat_state);
+void xor_matrix_free(XorMatrix* matrix);
+XorMatrix* xor_matrix_clone(const XorMatrix* matrix);
+
+//runs Gauss-Jordan propagation on the XOR constraints, interleaved with unit resolution
+//returns a clause whose literals are all false if a contradiction is found, NULL otherwise
+Clause* xor_propagate(SatState* sat_state);
+
+//returns the number of XOR constraints recovered from the cnf of sat state
+c2dSize sat_xor_count(const SatState* sat_state);
+
+/******************************************************************************
+ * Cardinality constraints
+ ******************************************************************************/
+
+//recovers the at-most-k constraints encoded by cnf clauses (NULL if there are none),
+//and detaches those clauses from the occurrence lists of literals (they remain cnf
+//clauses, so this saves propagation work rather than memory)
+CardSet* card_set_new(SatState* sat_state);
+void card_set_free(CardSet* set);
+CardSet* card_set_clone(const CardSet* set, const SatState* sat_state);
+
+//adds x to the number of true literals of the constraints mentioning lit
+void card_count(Lit* lit, SatState* sat_state, c2dLiteral x);
+
+//propagates the constraints mentioning lit, which has just been set to true
+//returns a clause whose literals are all false if a contradiction is found, NULL otherwise
+Clause* card_propagate(Lit* lit, SatState* sat_state);
+
+//returns the number of cardinality constraints recovered from the cnf of sat state
+c2dSize sat_card_count(const SatState* sat_state);
+
+//returns the number of cnf clauses that are propagated by cardinality constraints
+c2dSize sat_card_detached_count(const SatState* sat_state);
+
+/******************************************************************************
+ * Preprocessing
+ ******************************************************************************/
+
+//simplifies the cnf of sat state by unit propagation, subsumption, self-subsuming
+//strengthening, equivalent literal substitution and bounded variable elimination,
+//which preserve satisfiability but not the models (so this is not for knowledge
+//compilation)
+//
+//this is called at decision level 1, before any clause is learned
+//returns 0 if the cnf is found to be unsatisfiable (the sat state is then unchanged),
+//1 otherwise
+BOOLEAN sat_preprocess(SatState* sat_state);
+
+//extends the last model (see sat_model_literal()) to the variables eliminated by
+//sat_preprocess(), so that it satisfies the original cnf
+void sat_extend_model(SatState* sat_state);
+
+//returns the number of variables eliminated by sat_preprocess(), not counting
+//those it substituted
+c2dSize sat_eliminated_var_count(const SatState* sat_state);
+
+//simplifies the cnf of sat state by unit propagation, subsumption, self-subsuming
+//strengthening and equivalent literal substitution, keeping its models
+//
+//a substituted variable is kept equivalent to its replacement by two binary clauses
+//if keep_equivalences is 1; otherwise it no longer appears in the cnf, so each such
+//variable doubles the model count (see sat_substituted_var_count())
+//
+//equivalent variables are replaced by the largest one if largest_repr is 1, by the
+//smallest one otherwise: the replacement takes over their clauses, so a vtree built
+//from an elimination order stays narrower when it is the variable eliminated last
+//
+//this is called at decision level 1, before any clause is learned
+//returns 0 if the cnf is found to be unsatisfiable (the sat state is then unchanged),
+//1 otherwise
+BOOLEAN sat_simplify(BOOLEAN keep_equivalences, BOOLEAN largest_repr, SatState* sat_state);
+
+//returns the number of variables that sat_simplify() dropped from the cnf
+c2dSize sat_substituted_var_count(const SatState* sat_state);
+
+void elim_stack_free(ElimStack* stack);
+ElimStack* elim_stack_clone(const ElimStack* stack);
+
+/******************************************************************************
+ * Probing
+ ******************************************************************************/
+
+//decides each variable of a binary clause both ways at level 2, learning a unit
+//clause for every failed literal (one whose decision leads to a contradiction)
+//and for every literal implied by both decisions
+//
+//a literal implied by a longer clause under a decision is learned as implied by
+//a single literal, by a binary clause (lazy hyper-binary resolution); learned
+//binary clauses that other binary clauses imply are then removed (transitive
+//reduction)
+//
+//if backbone is 1, it then learns a unit clause for each literal that holds in
+//all models, found by one sat_solve_assuming() query per candidate literal; a query
+//gives up after learning BACKBONE_MAX_CONFLICTS clauses unless set otherwise by
+//sat_set_backbone_conflicts(), so the backbone found may be partial
+//
+//the models of the cnf do not change, so this may precede compiling and counting
+//this is called at decision level 1
+//returns 0 if the cnf is found to be unsatisfiable, 1 otherwise
+BOOLEAN sat_probe(BOOLEAN backbone, SatState* sat_state);
+
+//returns the number of binary clauses learned by hyper-binary resolution in probing,
+//and the number of learned binary clauses removed by transitive reduction
+c2dSize sat_hyper_binary_count(const SatState* sat_state);
+c2dSize sat_reduced_binary_count(const SatState* sat_state);
+
+//sets the number of clauses a backbone query may learn before it gives up, leaving
+//its candidate out of the backbone (0: no limit, so the backbone found is complete)
+void sat_set_backbone_conflicts(c2dSize max_conflicts, SatState* sat_state);
+
+//returns the number of backbone candidates whose query gave up
+c2dSize sat_backbone_gave_up_count(const SatState* sat_state);
+
+/******************************************************************************
+ * Symmetry breaking
+ ******************************************************************************/
+
+//finds symmetries of the cnf (permutations of its literals mapping its clauses to
+//its clauses) and adds a lex-leader constraint breaking each symmetry generator,
+//with auxiliary variables numbered after those of the cnf
+//
+//satisfiability is preserved but models are not, so this is for sat solving
+//only: it must not precede compiling or counting
+//this is called at decision level 1, before any clause is learned
+//returns the number of symmetry generators found
+c2dSize sat_break_symmetries(SatState* sat_state);
+
+/******************************************************************************
+ * Bounded variable addition
+ ******************************************************************************/
+
+//replaces each set of clauses {l or C : l in L, C in S} found in the cnf, such
+//as a pairwise at-most-one constraint, with the clauses -x or l (l in L) and
+//x or C (C in S), where x is a new variable numbered after those of the cnf, when
+//this leaves fewer clauses
+//
+//satisfiability is preserved but the model count is not (x is free when L and S
+//all hold), so this is for sat solving only: it must not precede compiling or
+//counting; its clauses are not logged in a DRAT proof
+//this is called at decision level 1, before any clause is learned
+//returns the number of variables added
+c2dSize sat_add_bounded_variables(SatState* sat_state);
+
+/******************************************************************************
+ * DRAT proofs
+ ******************************************************************************/
+
+//starts writing a binary DRAT proof to the file: from now on, the clauses added
+//and deleted by sat_assert_clause(), vivification, preprocessing and probing are
+//logged, and a background thread writes them out
+//
+//XOR reasoning is disabled, as its clauses could not be checked, and so must be
+//symmetry breaking, bounded variable addition and backbone extraction (which do
+//not log their clauses)
+//returns 0 if the file cannot be opened, 1 otherwise
+BOOLEAN sat_proof_open(const char* fname, SatState* sat_state);
+
+//ends the proof with the empty clause if unsat is 1, and closes its file
+//(this is also done, without the empty clause, when the sat state is freed)
+void sat_proof_close(BOOLEAN unsat, SatState* sat_state);
+
+//adds (step 'a') or deletes (step 'd') a clause in the proof (nothing if it is NULL)
+void proof_step(Proof* proof, char step, const c2dLiteral* lits, c2dSize size);
+void proof_clause_step(Proof* proof, char step, const Clause* clause);
+
+/******************************************************************************
+ * Trail saving
+ ******************************************************************************/
+
+//turns trail saving on (enable 1) or off (enable 0, the default)
+//
+//the literals undone by a backjump are then saved with their reasons, and when a
+//saved decision is made again, the literals it implied are set from their reasons
+//(if these are still unit) before unit resolution propagates them
+void sat_set_trail_saving(BOOLEAN enable, SatState* sat_state);
+
+//returns the number of literals set from their saved reasons instead of being
+//found by unit resolution
+c2dSize sat_replayed_literal_count(const SatState* sat_state);
+
+SavedTrail* saved_trail_new(void);
+void saved_trail_free(SavedTrail* trail);
+
+//saves the decisions above level and the literals implied at their levels, before
+//sat_undo_to_level() undoes them
+void trail_save(c2dSize level, SatState* sat_state);
+
+//replays the literals saved for the decision just made, and propagates them with it
+//returns a clause whose literals are all false if a contradiction is found, NULL otherwise
+Clause* trail_replay(Lit* decision, SatState* sat_state);
+
+//drops the saved literals (to be called before clauses are freed)
+void trail_forget(SatState* sat_state);
+
+//returns a node for lit at the end of a list of the trail of sat state (prev is the
+//last node of the list), carved from the blocks of sat state
+LitNode* trail_node_new(Lit* lit, LitNode* prev, SatState* sat_state);
+
+/******************************************************************************
+ * Adding and removing clauses
+ ******************************************************************************/
+
+//adds a new variable to the cnf of sat state, and returns its index
+c2dSize sat_add_var(SatState* sat_state);
+
+//adds the clause with the given literals (distinct, and over distinct variables)
+//to the cnf of sat state, after its other cnf clauses
+//
+//this is called at decision level 1; unit resolution then runs if the clause is unit
+//(or false) under the literals implied at level 1, and the learned clauses are kept
+//
+//added clauses are not part of the formula of sat state (sat_state_reset() drops
+//them), and are propagated as clauses, not as XOR or cardinality constraints;
+//clauses cannot be added after sat_preprocess() or while a DRAT proof is written
+//returns 0 if unit resolution finds a contradiction, 1 otherwise
+BOOLEAN sat_add_clause(const c2dLiteral* lits, c2dSize size, SatState* sat_state);
+
+//adds the clause with the given literals as sat_add_clause() does, together with a
+//new activation variable, and returns the activation literal: the clause holds only
+//when that literal is assumed (see sat_solve_assuming())
+//
+//the activation literal must only be assumed, not added to the cnf or decided at level 1
+c2dLiteral sat_add_removable_clause(const c2dLiteral* lits, c2dSize size, SatState* sat_state);
+
+//removes the clause added with the activation literal, and the learned clauses
+//that depend on it (the activation variable is then false)
+//
+//this is called at decision level 1
+//returns 0 if unit resolution then finds a contradiction, 1 otherwise
+BOOLEAN sat_remove_clause(c2dLiteral activation, SatState* sat_state);
+
+//adds variables n+1..new_n to sat state
+void extend_vars(c2dSize new_n, SatState* sat_state);
+
+/******************************************************************************
+ * Saving and loading learned clauses
+ ******************************************************************************/
+
+//saves the learned clauses of sat state with at most max_size literals (except those
+//satisfied at level 1) to a binary file, keyed by the hash of its formula
+//
+//nothing is saved if clauses that do not follow from the formula were added to the
+//cnf (by symmetry breaking or sat_add_clause())
+//returns the number of clauses saved (0 as well if the file cannot be written)
+c2dSize sat_save_learned_clauses(const char* file_name, c2dSize max_size, const SatState* sat_state);
+
+//adds the clauses saved to the file by sat_save_learned_clauses() to the learned clauses
+//of sat state, and checks them with unit resolution (whose implications are then
+//undone); nothing is added if the file does not exist or was saved for a different
+//formula
+//
+//learned clauses follow from the formula, so the models of the cnf do not change; a
+//clause is skipped if one of its variables is mentioned by no cnf clause (such as the
+//variables sat_simplify() drops), so this may follow sat_simplify(), and precede
+//compiling and counting
+//this is called at decision level 1, while no DRAT proof is written
+//returns 0 if unit resolution finds a contradiction, 1 otherwise
+BOOLEAN sat_load_learned_clauses(const char* file_name, SatState* sat_state);
+
+/******************************************************************************
+ * Large tables
+ ******************************************************************************/
+
+//sets how tables of 2 MB or more (trail nodes, the cache of c2D) allocated from now
+//on are backed: 0 base pages only, 1 transparent huge pages (the default), 2 huge
+//pages from the hugetlbfs pool, or transparent ones when the pool is empty
+void sat_set_huge_pages(int mode);
+
+//returns a zeroed table of size bytes (NULL if memory is exhausted)
+//
+//a table of 2 MB or more is mapped aligned to huge pages (its pages are not bound
+//to a NUMA node)
+void* sat_large_alloc(size_t size);
+
+//frees a table returned by sat_large_alloc(size)
+void sat_large_free(void* table, size_t size);
+
 /******************************************************************************
  * The functions below are already implemented for you and MUST STAY AS IS
  ******************************************************************************/
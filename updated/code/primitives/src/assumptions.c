@@ -0,0 +1,184 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Incremental solving under assumptions
+ *
+ * A query checks the satisfiability of the cnf together with a set of assumption
+ * literals. The assumptions are decided first, one decision level each, starting
+ * from level 2 (and propagated together). Search then continues above the
+ * assumption levels exactly as in the sat solver (decide, learn, backtrack to
+ * the assertion level).
+ *
+ * Clauses learned by a query are implied by the cnf alone (the assumptions are
+ * decisions, not clauses), so they stay in the sat state and are reused by the
+ * queries that follow.
+ *
+ * A query fails when the negation of an assumption is implied by the assumptions
+ * decided before it. The failed assumptions are then found by walking the
+ * implication graph backwards from that literal to the decisions it depends on.
+ ******************************************************************************/
+
+//returns a literal which is free in the current setting of sat state
+static Lit* free_literal(const SatState* sat_state) {
+    for(c2dSize i = 1; i <= sat_var_count(sat_state); ++i) {
+        Var* var = sat_index2var(i, sat_state);
+        if (!sat_instantiated_var(var)) return sat_pos_literal(var);
+    }
+    return NULL;
+}
+
+//saves the current setting of sat state (all variables instantiated) as the model
+void sat_save_model(SatState* sat_state) {
+    for(c2dSize i = 1; i <= sat_var_count(sat_state); ++i)
+        sat_state->model[i] =
+            sat_implied_literal(sat_pos_literal(sat_index2var(i, sat_state)));
+}
+
+//collects the decisions that the implied literal lit depends on
+//every decision made below the search levels is an assumption
+static void collect_failed(Lit* lit, BOOLEAN* visited, SatState* sat_state) {
+    c2dSize id = lit->index + sat_state->n;
+    if (visited[id]) return;
+    visited[id] = 1;
+    if (lit->decision_level <= 1) return;
+    if (lit->n_implied_by == 0)
+        sat_state->failed_assumptions[sat_state->n_failed_assumptions++] = lit;
+    else
+        for(c2dSize i = 0; i < lit->n_implied_by; ++i)
+            collect_failed(lit->implied_by[i], visited, sat_state);
+}
+
+static void analyze_failed(Lit* lit, SatState* sat_state) {
+    BOOLEAN* visited = calloc(2 * sat_state->n + 1, sizeof(BOOLEAN));
+    sat_state->failed_assumptions[sat_state->n_failed_assumptions++] = lit;
+    visited[lit->index + sat_state->n] = 1;
+    collect_failed(sat_literal_complement(lit), visited, sat_state);
+    free(visited);
+    sat_state->assumption_failed = 1;
+}
+
+//counts a clause learned by the current query, and returns 1 if the query has now
+//learned as many as it may (it then gives up)
+static BOOLEAN out_of_conflicts(SatState* sat_state) {
+    if (sat_state->query_conflicts == 0 || --sat_state->query_conflicts > 0) return 0;
+    sat_state->query_gave_up = 1;
+    return 1;
+}
+
+//if the sat state is shown to be satisfiable, it returns NULL
+//otherwise, a clause must be learned and it is returned
+//
+//NULL is also returned when the query gives up (see out_of_conflicts())
+static Clause* search_aux(SatState* sat_state) {
+    Lit* lit = free_literal(sat_state);
+    if (lit == NULL) { //all literals are implied
+        sat_save_model(sat_state);
+        return NULL;
+    }
+
+    Clause* learned = sat_decide_literal(lit, sat_state);
+    if (learned == NULL) learned = search_aux(sat_state);
+    sat_undo_decide_literal(sat_state);
+
+    if (learned != NULL) { //there is a conflict
+        if (sat_at_assertion_level(learned, sat_state)) {
+            learned = sat_assert_clause(learned, sat_state);
+            if (learned == NULL && out_of_conflicts(sat_state)) return NULL;
+            if (learned == NULL) return search_aux(sat_state); //try again
+        }
+        return learned; //backtrack
+    }
+    return NULL; //satisfiable
+}
+
+//decides the assumptions lits[i..k-1] (skipping the ones already implied),
+//and then searches for a model
+//
+//the assumptions are decided at once (see sat_decide_literals()), up to the first
+//one over a variable already set or met (which is then implied, or fails); their
+//levels are undone one at a time, each one handling a learned clause asserted at
+//its level as if its assumption had been decided on its own
+//
+//returns NULL if a model was found or an assumption failed (the sat state tells
+//them apart), otherwise a clause was learned and it is returned
+static Clause* assume_aux(Lit** lits, c2dSize i, c2dSize k, BOOLEAN* seen, SatState* sat_state) {
+    while (i < k && sat_implied_literal(lits[i])) ++i;
+    if (i == k) return search_aux(sat_state);
+    if (sat_implied_literal(sat_literal_complement(lits[i]))) {
+        analyze_failed(lits[i], sat_state);
+        return NULL;
+    }
+
+    Lit** cube = malloc(sizeof(Lit*) * (k - i));
+    c2dSize* at = malloc(sizeof(c2dSize) * (k - i)); //position of each decision in lits
+    c2dSize count = 0;
+    c2dSize j = i;
+    for( ; j < k; ++j) {
+        Lit* lit = lits[j];
+        if (sat_implied_literal(lit)) continue;
+        if (sat_instantiated_var(lit->var) || seen[lit->var->index]) break;
+        seen[lit->var->index] = 1;
+        cube[count] = lit;
+        at[count++] = j;
+    }
+    for(c2dSize c = 0; c < count; ++c) seen[cube[c]->var->index] = 0;
+
+    Clause* learned = sat_decide_literals(cube, count, sat_state);
+    if (learned == NULL) learned = assume_aux(lits, j, k, seen, sat_state);
+    for(c2dSize c = count; c > 0; --c) {
+        sat_undo_decide_literal(sat_state);
+        if (learned != NULL && sat_at_assertion_level(learned, sat_state)) {
+            learned = sat_assert_clause(learned, sat_state);
+            if (learned == NULL && !out_of_conflicts(sat_state))
+                learned = assume_aux(lits, at[c - 1], k, seen, sat_state);
+        }
+    }
+    free(cube);
+    free(at);
+    return learned;
+}
+
+//checks the satisfiability of the cnf together with the assumption literals lits[0..k-1],
+//giving up once max_conflicts clauses are learned (0 for no limit)
+//returns 1 if satisfiable, 0 if not, and -1 if it gave up
+int sat_solve_assuming_bounded(Lit** lits, c2dSize k, c2dSize max_conflicts, SatState* sat_state) {
+    assert(sat_state->current_level == 1);
+    sat_state->query_conflicts = max_conflicts;
+    sat_state->query_gave_up = 0;
+    free(sat_state->failed_assumptions);
+    sat_state->failed_assumptions = malloc(sizeof(Lit*) * (k + 1));
+    sat_state->n_failed_assumptions = 0;
+    sat_state->assumption_failed = 0;
+
+    int ret = 0;
+    BOOLEAN* seen = calloc(sat_state->n + 1, sizeof(BOOLEAN)); //variables of a cube
+    if (sat_unit_resolution(sat_state))
+        ret = assume_aux(lits, 0, k, seen, sat_state) == NULL &&
+              !sat_state->assumption_failed;
+    if (sat_state->query_gave_up) ret = -1;
+    sat_undo_unit_resolution(sat_state); // back to the initial setting
+    free(seen);
+    return ret;
+}
+
+//checks the satisfiability of the cnf together with the assumption literals lits[0..k-1]
+//returns 1 if satisfiable, 0 otherwise
+BOOLEAN sat_solve_assuming(Lit** lits, c2dSize k, SatState* sat_state) {
+    return sat_solve_assuming_bounded(lits, k, 0, sat_state) == 1;
+}
+
+//returns the assumptions responsible for the last unsatisfiable query
+Lit** sat_failed_assumptions(c2dSize* count, const SatState* sat_state) {
+    *count = sat_state->n_failed_assumptions;
+    return sat_state->failed_assumptions;
+}
+
+//returns 1 if the literal is true in the last model found, 0 otherwise
+BOOLEAN sat_model_literal(const Lit* lit, const SatState* sat_state) {
+    BOOLEAN value = sat_state->model[lit->var->index];
+    return lit->index > 0 ? value : !value;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,416 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Bounded variable addition (SimpleBVA)
+ *
+ * A set of clauses that is the product of a set of literals Mlit and a set of
+ * clauses Mcls, {l or C : l in Mlit, C in Mcls}, is replaced with
+ *   -x or l    for each l in Mlit
+ *   x or C     for each C in Mcls
+ * where x is a new variable: |Mlit| * |Mcls| clauses become |Mlit| + |Mcls|.
+ * Pairwise at-most-one constraints are such products (Mlit = {-a, -b}, Mcls =
+ * {-c}, {-d}, ...), so a quadratic encoding shrinks to a linear one.
+ *
+ * The product is grown from the clauses of a literal l, Mlit = {l} and Mcls their
+ * other literals: a literal l' is added to Mlit (keeping in Mcls the clauses C
+ * such that l' or C is a clause too) as long as this removes more clauses. The
+ * literals are tried in order of occurrences, most first, and a literal is tried
+ * again after a reduction involving it. The search gives up after BVA_MAX_WORK
+ * literals are compared.
+ *
+ * Each removed clause follows from the new ones, and each model of the old cnf
+ * extends to x, so satisfiability is preserved; the model count is not (x is free
+ * when all of Mlit and all of Mcls hold), which is why this is for sat solving only.
+ ******************************************************************************/
+
+#define BVA_MAX_WORK 50000000 //literals compared by the search
+
+typedef struct {
+    c2dLiteral* lits;
+    c2dSize size;
+    BOOLEAN removed;
+} BClause;
+
+typedef struct {
+    c2dSize* ids;
+    c2dSize n;
+    c2dSize buf_len;
+} OccList;
+
+typedef struct {
+    c2dLiteral lit;     //the literal of Mlit to add
+    c2dSize id;         //the clause of Mcls it matches
+} Match;
+
+typedef struct {
+    c2dSize n;          //variables, those added included
+    BClause* clauses;
+    c2dSize n_clauses;
+    c2dSize clauses_buf_len;
+    OccList* occ;       //occ[code(l)] lists the clauses containing literal l
+    c2dSize* stamp;     //scratch: stamp[code(l)] == time if l is in the clause marked
+    c2dSize* count;     //scratch: matches of each literal
+    c2dSize* last;      //scratch: last clause of Mcls (+1) a literal matched
+    c2dSize time;
+    c2dLiteral* queue;  //literals to try
+    c2dSize queue_head;
+    c2dSize queue_tail;
+    c2dSize queue_buf_len;
+    c2dSize* mcls;      //Mcls, as ids of the clauses of l
+    c2dSize n_mcls;
+    c2dLiteral* mlit;   //Mlit
+    c2dSize n_mlit;
+    Match* matches;
+    c2dSize n_matches;
+    c2dSize matches_buf_len;
+    unsigned long work;
+    c2dSize n_removed;
+} Bva;
+
+/******************************************************************************
+ * Clauses and occurrence lists
+ ******************************************************************************/
+
+//literals are numbered 2v (v) and 2v+1 (-v), so arrays grow with variables
+static c2dSize code(c2dLiteral lit) {
+    return lit > 0 ? 2 * (c2dSize)lit : 2 * (c2dSize)-lit + 1;
+}
+
+static OccList* occ_of(Bva* b, c2dLiteral lit) {
+    return &b->occ[code(lit)];
+}
+
+static void occ_add(OccList* list, c2dSize id) {
+    if (list->n == list->buf_len) {
+        list->buf_len = list->buf_len ? 2 * list->buf_len : 4;
+        list->ids = realloc(list->ids, sizeof(c2dSize) * list->buf_len);
+    }
+    list->ids[list->n++] = id;
+}
+
+//drops removed clauses from an occurrence list, returns its length
+static c2dSize occ_clean(Bva* b, OccList* list) {
+    c2dSize kept = 0;
+    for(c2dSize i = 0; i < list->n; ++i)
+        if (!b->clauses[list->ids[i]].removed) list->ids[kept++] = list->ids[i];
+    list->n = kept;
+    return kept;
+}
+
+//adds a clause, taking its literals
+static void add_clause(Bva* b, c2dLiteral* lits, c2dSize size) {
+    if (b->n_clauses == b->clauses_buf_len) {
+        b->clauses_buf_len = b->clauses_buf_len ? 2 * b->clauses_buf_len : 64;
+        b->clauses = realloc(b->clauses, sizeof(BClause) * b->clauses_buf_len);
+    }
+    c2dSize id = b->n_clauses++;
+    b->clauses[id].lits = lits;
+    b->clauses[id].size = size;
+    b->clauses[id].removed = 0;
+    for(c2dSize j = 0; j < size; ++j) occ_add(occ_of(b, lits[j]), id);
+}
+
+static void remove_clause(Bva* b, c2dSize id) {
+    b->clauses[id].removed = 1;
+    ++b->n_removed;
+}
+
+//returns a new variable
+static c2dSize add_var(Bva* b) {
+    c2dSize n = ++b->n;
+    b->occ = realloc(b->occ, sizeof(OccList) * 2 * (n + 1));
+    b->stamp = realloc(b->stamp, sizeof(c2dSize) * 2 * (n + 1));
+    b->count = realloc(b->count, sizeof(c2dSize) * 2 * (n + 1));
+    b->last = realloc(b->last, sizeof(c2dSize) * 2 * (n + 1));
+    memset(b->occ + 2 * n, 0, sizeof(OccList) * 2);
+    memset(b->stamp + 2 * n, 0, sizeof(c2dSize) * 2);
+    memset(b->count + 2 * n, 0, sizeof(c2dSize) * 2);
+    memset(b->last + 2 * n, 0, sizeof(c2dSize) * 2);
+    return n;
+}
+
+static void enqueue(Bva* b, c2dLiteral lit) {
+    if (b->queue_tail == b->queue_buf_len) {
+        b->queue_buf_len = b->queue_buf_len ? 2 * b->queue_buf_len : 64;
+        b->queue = realloc(b->queue, sizeof(c2dLiteral) * b->queue_buf_len);
+    }
+    b->queue[b->queue_tail++] = lit;
+}
+
+static void add_match(Bva* b, c2dLiteral lit, c2dSize id) {
+    if (b->n_matches == b->matches_buf_len) {
+        b->matches_buf_len = b->matches_buf_len ? 2 * b->matches_buf_len : 64;
+        b->matches = realloc(b->matches, sizeof(Match) * b->matches_buf_len);
+    }
+    b->matches[b->n_matches].lit = lit;
+    b->matches[b->n_matches].id = id;
+    ++b->n_matches;
+}
+
+/******************************************************************************
+ * Growing and applying a product
+ ******************************************************************************/
+
+//clauses removed by replacing a product of m_lit literals and m_cls clauses
+static long reduction(c2dSize m_lit, c2dSize m_cls) {
+    return (long)(m_lit * m_cls) - (long)m_lit - (long)m_cls;
+}
+
+//marks the literals of clause id but lit, with a new time
+static void mark_clause(Bva* b, c2dSize id, c2dLiteral lit) {
+    ++b->time;
+    BClause* clause = &b->clauses[id];
+    for(c2dSize j = 0; j < clause->size; ++j)
+        if (clause->lits[j] != lit) b->stamp[code(clause->lits[j])] = b->time;
+}
+
+//returns the literal l' of clause d that is not marked if it is the only one,
+//and d has as many literals as the clause marked (d is then C or l'), 0 otherwise
+static c2dLiteral other_literal(Bva* b, const BClause* d, c2dSize size) {
+    if (d->size != size) return 0;
+    b->work += size;
+    c2dLiteral other = 0;
+    for(c2dSize j = 0; j < size; ++j) {
+        if (b->stamp[code(d->lits[j])] == b->time) continue;
+        if (other != 0) return 0;
+        other = d->lits[j];
+    }
+    if (other != 0 && b->stamp[code(-other)] == b->time) return 0; //a tautology
+    return other;
+}
+
+static BOOLEAN in_mlit(const Bva* b, c2dLiteral lit) {
+    for(c2dSize i = 0; i < b->n_mlit; ++i)
+        if (b->mlit[i] == lit) return 1;
+    return 0;
+}
+
+//finds the literals l' such that l' or C is a clause, for each C in Mcls
+static void find_matches(Bva* b, c2dLiteral lit) {
+    b->n_matches = 0;
+    for(c2dSize i = 0; i < b->n_mcls; ++i) {
+        c2dSize id = b->mcls[i];
+        BClause* clause = &b->clauses[id];
+        //the other literal of C that occurs least
+        c2dLiteral least = 0;
+        for(c2dSize j = 0; j < clause->size; ++j) {
+            c2dLiteral l = clause->lits[j];
+            if (l != lit && (least == 0 || occ_of(b, l)->n < occ_of(b, least)->n)) least = l;
+        }
+        mark_clause(b, id, lit);
+        OccList* list = occ_of(b, least);
+        for(c2dSize k = 0; k < list->n; ++k) {
+            BClause* d = &b->clauses[list->ids[k]];
+            if (d->removed || list->ids[k] == id) continue;
+            c2dLiteral other = other_literal(b, d, clause->size);
+            if (other == 0 || other == lit || in_mlit(b, other)) continue;
+            if (b->last[code(other)] == i + 1) continue; //a duplicate clause
+            b->last[code(other)] = i + 1;
+            add_match(b, other, id);
+        }
+    }
+    for(c2dSize i = 0; i < b->n_matches; ++i) b->last[code(b->matches[i].lit)] = 0;
+}
+
+//returns the literal matching the most clauses of Mcls (0 if none), and their number
+static c2dLiteral best_match(Bva* b, c2dSize* best_count) {
+    c2dLiteral best = 0;
+    *best_count = 0;
+    for(c2dSize i = 0; i < b->n_matches; ++i) {
+        c2dSize c = ++b->count[code(b->matches[i].lit)];
+        if (c > *best_count) {
+            *best_count = c;
+            best = b->matches[i].lit;
+        }
+    }
+    for(c2dSize i = 0; i < b->n_matches; ++i) b->count[code(b->matches[i].lit)] = 0;
+    return best;
+}
+
+//removes the clause l' or C (C being clause id of Mcls without lit), if it is still there
+static void remove_product_clause(Bva* b, c2dSize id, c2dLiteral lit, c2dLiteral other) {
+    mark_clause(b, id, lit);
+    OccList* list = occ_of(b, other);
+    for(c2dSize k = 0; k < list->n; ++k) {
+        BClause* d = &b->clauses[list->ids[k]];
+        if (!d->removed && other_literal(b, d, b->clauses[id].size) == other) {
+            remove_clause(b, list->ids[k]);
+            return;
+        }
+    }
+}
+
+//replaces the product of Mlit and Mcls with a new variable x
+static void apply(Bva* b, c2dLiteral lit) {
+    c2dLiteral x = (c2dLiteral)add_var(b);
+    for(c2dSize i = 0; i < b->n_mlit; ++i) {
+        c2dLiteral* lits = malloc(sizeof(c2dLiteral) * 2);
+        lits[0] = -x;
+        lits[1] = b->mlit[i];
+        add_clause(b, lits, 2);
+    }
+    for(c2dSize i = 0; i < b->n_mcls; ++i) {
+        c2dSize id = b->mcls[i];
+        c2dSize size = b->clauses[id].size;
+        c2dLiteral* lits = malloc(sizeof(c2dLiteral) * size);
+        lits[0] = x;
+        c2dSize s = 1;
+        for(c2dSize j = 0; j < size; ++j)
+            if (b->clauses[id].lits[j] != lit) lits[s++] = b->clauses[id].lits[j];
+        add_clause(b, lits, s);
+    }
+    for(c2dSize i = 0; i < b->n_mcls; ++i) {
+        c2dSize id = b->mcls[i];
+        for(c2dSize k = 1; k < b->n_mlit; ++k) remove_product_clause(b, id, lit, b->mlit[k]);
+        remove_clause(b, id);
+    }
+    enqueue(b, lit);
+    enqueue(b, x);
+}
+
+//grows a product from the clauses of lit, and replaces it if this removes clauses
+static void reduce(Bva* b, c2dLiteral lit) {
+    OccList* list = occ_of(b, lit);
+    if (occ_clean(b, list) < 3) return; //too few clauses to remove any
+    b->mcls = realloc(b->mcls, sizeof(c2dSize) * list->n);
+    b->n_mcls = 0;
+    for(c2dSize i = 0; i < list->n; ++i)
+        if (b->clauses[list->ids[i]].size > 1) b->mcls[b->n_mcls++] = list->ids[i];
+    b->n_mlit = 0;
+    b->mlit[b->n_mlit++] = lit;
+
+    while (b->work < BVA_MAX_WORK) {
+        find_matches(b, lit);
+        c2dSize n_best;
+        c2dLiteral best = best_match(b, &n_best);
+        if (best == 0 || reduction(b->n_mlit + 1, n_best) <= reduction(b->n_mlit, b->n_mcls)) break;
+        b->mlit = realloc(b->mlit, sizeof(c2dLiteral) * (b->n_mlit + 1));
+        b->mlit[b->n_mlit++] = best;
+        c2dSize kept = 0;
+        for(c2dSize i = 0; i < b->n_matches; ++i)
+            if (b->matches[i].lit == best) b->mcls[kept++] = b->matches[i].id;
+        b->n_mcls = kept;
+    }
+    if (b->n_mlit > 1 && reduction(b->n_mlit, b->n_mcls) > 0) apply(b, lit);
+}
+
+static int compare_occurrences(const void* a, const void* b) {
+    const c2dSize* x = a;
+    const c2dSize* y = b;
+    return x[0] > y[0] ? -1 : (x[0] < y[0] ? 1 : (x[1] < y[1] ? -1 : x[1] > y[1]));
+}
+
+/******************************************************************************
+ * Loading and storing the cnf of a sat state
+ ******************************************************************************/
+
+static void bva_init(Bva* b, const SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    memset(b, 0, sizeof(Bva));
+    b->n     = n;
+    b->occ   = calloc(2 * (n + 1), sizeof(OccList));
+    b->stamp = calloc(2 * (n + 1), sizeof(c2dSize));
+    b->count = calloc(2 * (n + 1), sizeof(c2dSize));
+    b->last  = calloc(2 * (n + 1), sizeof(c2dSize));
+    b->mlit  = malloc(sizeof(c2dLiteral));
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        c2dLiteral* lits = malloc(sizeof(c2dLiteral) * (clause->n_literals + 1));
+        c2dSize size = 0;
+        ++b->time; //drop duplicate literals, so that a clause matched is a product clause
+        for(c2dSize j = 0; j < clause->n_literals; ++j) {
+            c2dLiteral lit = clause->literals[j]->index;
+            if (b->stamp[code(lit)] == b->time) continue;
+            b->stamp[code(lit)] = b->time;
+            lits[size++] = lit;
+        }
+        add_clause(b, lits, size);
+    }
+
+    //literals by occurrences, most first
+    c2dSize* order = malloc(sizeof(c2dSize) * 4 * (n + 1));
+    c2dSize n_lits = 0;
+    for(c2dSize c = 2; c < 2 * (n + 1); ++c) {
+        if (b->occ[c].n < 3) continue;
+        order[2 * n_lits] = b->occ[c].n;
+        order[2 * n_lits + 1] = c;
+        ++n_lits;
+    }
+    qsort(order, n_lits, 2 * sizeof(c2dSize), compare_occurrences);
+    for(c2dSize i = 0; i < n_lits; ++i) {
+        c2dSize v = order[2 * i + 1] / 2;
+        enqueue(b, order[2 * i + 1] % 2 ? -(c2dLiteral)v : (c2dLiteral)v);
+    }
+    free(order);
+}
+
+static void bva_free(Bva* b) {
+    for(c2dSize id = 0; id < b->n_clauses; ++id) free(b->clauses[id].lits);
+    free(b->clauses);
+    for(c2dSize c = 0; c < 2 * (b->n + 1); ++c) free(b->occ[c].ids);
+    free(b->occ);
+    free(b->stamp);
+    free(b->count);
+    free(b->last);
+    free(b->queue);
+    free(b->mcls);
+    free(b->mlit);
+    free(b->matches);
+}
+
+//replaces the cnf of sat state with the clauses kept and added, over the variables added
+static void store(Bva* b, SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    xor_matrix_free(sat_state->xor_matrix);
+    card_set_free(sat_state->card_set);
+    extend_vars(b->n, sat_state);
+    sat_state->extended = 1;
+
+    for(c2dSize i = 0; i < n; ++i) {
+        sat_state->variables[i]->n_clauses = 0;
+        sat_state->pos_literals[i]->n_clauses = 0;
+        sat_state->neg_literals[i]->n_clauses = 0;
+    }
+    trail_forget(sat_state);
+    for(c2dSize i = 0; i < sat_state->m; ++i) Clause_delete(sat_state->CNF_clauses[i]);
+
+    c2dSize m = b->n_clauses - b->n_removed;
+    sat_state->m = m;
+    sat_state->CNF_clauses = realloc(sat_state->CNF_clauses, sizeof(Clause*) * (m + 1));
+    c2dSize i = 0;
+    for(c2dSize id = 0; id < b->n_clauses; ++id) {
+        BClause* clause = &b->clauses[id];
+        if (clause->removed) continue;
+        Lit** literals = malloc(sizeof(Lit*) * clause->size);
+        for(c2dSize j = 0; j < clause->size; ++j)
+            literals[j] = sat_index2literal(clause->lits[j], sat_state);
+        ++i;
+        sat_state->CNF_clauses[i - 1] = Clause_new(i, literals, clause->size, m);
+    }
+    sat_state->xor_matrix = xor_matrix_new(sat_state);
+    sat_state->card_set = card_set_new(sat_state);
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//replaces products of literals and clauses in the cnf with new variables
+//returns the number of variables added
+c2dSize sat_add_bounded_variables(SatState* sat_state) {
+    assert(sat_state->current_level == 1 && sat_state->n_learned_clauses == 0);
+    c2dSize n = sat_state->n;
+    Bva b;
+    bva_init(&b, sat_state);
+    while (b.queue_head < b.queue_tail && b.work < BVA_MAX_WORK)
+        reduce(&b, b.queue[b.queue_head++]);
+
+    c2dSize added = b.n - n;
+    if (added > 0) store(&b, sat_state);
+    bva_free(&b);
+    return added;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,592 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Cardinality constraints
+ *
+ * Quasigroup and scheduling problems state "at most one of l1, ..., lk" as the
+ * k(k-1)/2 binary clauses (-li or -lj). Each of these clauses sits in the
+ * occurrence lists of two literals, and unit resolution visits all of them
+ * whenever one of the literals becomes true. More generally, "at most b of
+ * l1, ..., lk" is stated by the clauses (-li1 or ... or -lib+1), one for each
+ * b+1 of the literals.
+ *
+ * When a sat state is constructed, every binary clause (a or b) is read as an
+ * edge between -a and -b (literals that cannot be true together), and the
+ * graph is covered greedily by cliques. Every clique of 3 or more literals
+ * becomes a constraint "at most bound of l1, ..., lk are true" (bound is 1 for
+ * cliques), and the clauses of its edges are detached from the occurrence lists
+ * of literals. Clauses of b+1 literals (1 < b <= CARD_MAX_BOUND) are read the
+ * same way as hyperedges over the negations of their literals, and are covered
+ * greedily by groups of at least b+2 literals, each b+1 of which is a hyperedge:
+ * a group becomes a constraint with bound b.
+ *
+ * A constraint keeps the number of its true literals, which is updated together
+ * with the n_false counters of clauses (see modify_n_false()). Once the number
+ * reaches the bound, the other literals of the constraint are implied false, and
+ * going over the bound is a conflict. Both are explained by the clause made of
+ * the negations of the true literals (together with the implied literal), which
+ * is what unit resolution and construct_asserted_clause() expect from a clause.
+ *
+ * Detached clauses stay cnf clauses: they keep their indices, their variables
+ * still mention them, and sat_subsumed_clause() checks their literals directly.
+ * They are needed as such by c2D (which reads the cnf through sat_index2clause()
+ * and sat_clause_of_var()), by local search and by the detection run again after
+ * the cnf changes. Detaching saves propagation work, and the memory of their
+ * entries in the occurrence lists only: the clauses themselves are not freed, so
+ * memory hardly changes (on the qg family, for one).
+ ******************************************************************************/
+
+#define CARD_MIN_SIZE  3 //smallest clique turned into a constraint
+#define CARD_MAX_BOUND 2 //largest bound recovered from clauses longer than 2
+
+struct card_set {
+    c2dSize n_cards;
+    c2dSize* start;      //literals of constraint c are lits[start[c]..start[c+1]-1]
+    Lit** lits;
+    c2dSize* bound;      //at most bound[c] of the literals of constraint c are true
+    c2dSize* n_true;     //number of true literals of each constraint
+    c2dSize* occ_start;  //constraints of literal l are occ[occ_start[id]..occ_start[id+1]-1]
+    c2dSize* occ;        //(id is l->index + n)
+    c2dSize n;           //variables when the constraints were recovered (later ones are in none)
+    c2dSize n_detached;  //number of clauses detached from occurrence lists
+    Lit** literals;      //literals of the explaining clause
+    Clause reason;       //explaining clause (not part of the sat state)
+};
+
+static c2dSize lit_id(const Lit* lit, const SatState* sat_state) {
+    return lit->index + sat_state->n;
+}
+
+/******************************************************************************
+ * Detecting at-most-one constraints
+ ******************************************************************************/
+
+//the edges of the graph, as adjacency lists indexed by literal id
+//a binary clause (a or b) is the edge between -a and -b
+typedef struct {
+    c2dSize* start;
+    Lit** neighbor;
+    Clause** clause;
+    BOOLEAN* used;       //edge already covered by a clique
+} Graph;
+
+static BOOLEAN is_edge(const Clause* clause) {
+    return clause->n_literals == 2 &&
+           clause->literals[0]->var != clause->literals[1]->var;
+}
+
+static void graph_new(Graph* graph, SatState* sat_state) {
+    c2dSize ids = 2 * sat_state->n + 1;
+    graph->start = calloc(ids + 1, sizeof(c2dSize));
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        if (!is_edge(clause)) continue;
+        for(c2dSize j = 0; j < 2; ++j)
+            ++graph->start[lit_id(sat_literal_complement(clause->literals[j]), sat_state) + 1];
+    }
+    for(c2dSize id = 0; id < ids; ++id) graph->start[id + 1] += graph->start[id];
+
+    c2dSize n_edges = graph->start[ids];
+    c2dSize* fill = malloc(sizeof(c2dSize) * ids);
+    memcpy(fill, graph->start, sizeof(c2dSize) * ids);
+    graph->neighbor = malloc(sizeof(Lit*) * (n_edges + 1));
+    graph->clause = malloc(sizeof(Clause*) * (n_edges + 1));
+    graph->used = calloc(n_edges + 1, sizeof(BOOLEAN));
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        if (!is_edge(clause)) continue;
+        for(c2dSize j = 0; j < 2; ++j) {
+            //-literals[j] is adjacent to -literals[1-j]
+            c2dSize e = fill[lit_id(sat_literal_complement(clause->literals[j]), sat_state)]++;
+            graph->neighbor[e] = sat_literal_complement(clause->literals[1 - j]);
+            graph->clause[e] = clause;
+        }
+    }
+    free(fill);
+}
+
+static void graph_free(Graph* graph) {
+    free(graph->start);
+    free(graph->neighbor);
+    free(graph->clause);
+    free(graph->used);
+}
+
+//the edges of literal lit are first_edge(lit)..last_edge(lit)-1
+static c2dSize first_edge(const Graph* graph, const Lit* lit, const SatState* sat_state) {
+    return graph->start[lit_id(lit, sat_state)];
+}
+
+static c2dSize last_edge(const Graph* graph, const Lit* lit, const SatState* sat_state) {
+    return graph->start[lit_id(lit, sat_state) + 1];
+}
+
+//grows a clique from literal first over edges not covered yet, adding a neighbor
+//of first whenever it is adjacent to all the literals of the clique
+//
+//count[id] is the number of clique literals adjacent to literal id (all zeros on
+//entry and exit), member[id] is set for the clique literals
+static c2dSize grow_clique(Lit* first, Graph* graph, Lit** clique, c2dSize* count,
+                           BOOLEAN* member, Lit** touched, SatState* sat_state) {
+    c2dSize size = 0;
+    c2dSize n_touched = 0;
+    clique[size++] = first;
+    member[lit_id(first, sat_state)] = 1;
+    for(c2dSize k = 0; k < size; ++k) {
+        //count the neighbors of the newest clique literal
+        Lit* lit = clique[k];
+        //(only literals adjacent to all the previous ones are counted, which also
+        //ignores duplicate edges)
+        for(c2dSize e = first_edge(graph, lit, sat_state); e < last_edge(graph, lit, sat_state); ++e) {
+            c2dSize id = lit_id(graph->neighbor[e], sat_state);
+            if (graph->used[e] || count[id] != k) continue;
+            if (count[id]++ == 0) touched[n_touched++] = graph->neighbor[e];
+        }
+        if (k + 1 < size) continue;
+        //look for the next literal among the neighbors of first
+        for(c2dSize e = first_edge(graph, first, sat_state); e < last_edge(graph, first, sat_state); ++e) {
+            Lit* next = graph->neighbor[e];
+            c2dSize id = lit_id(next, sat_state);
+            if (graph->used[e] || member[id] || count[id] != size) continue;
+            clique[size++] = next;
+            member[id] = 1;
+            break;
+        }
+    }
+    for(c2dSize i = 0; i < n_touched; ++i) count[lit_id(touched[i], sat_state)] = 0;
+    return size;
+}
+
+//marks the edges between the literals of a clique as covered, and detaches their clauses
+static c2dSize cover_clique(Lit** clique, c2dSize size, Graph* graph,
+                            const BOOLEAN* member, SatState* sat_state) {
+    c2dSize n_detached = 0;
+    for(c2dSize k = 0; k < size; ++k)
+        for(c2dSize e = first_edge(graph, clique[k], sat_state); e < last_edge(graph, clique[k], sat_state); ++e) {
+            if (!member[lit_id(graph->neighbor[e], sat_state)]) continue;
+            graph->used[e] = 1;
+            if (!graph->clause[e]->detached) {
+                graph->clause[e]->detached = 1;
+                ++n_detached;
+            }
+        }
+    return n_detached;
+}
+
+//removes the detached clauses from the occurrence lists of literals
+static void detach_clauses(SatState* sat_state) {
+    for(c2dSize i = 1; i <= sat_state->n; ++i) {
+        Lit* lits[2] = {sat_state->pos_literals[i - 1], sat_state->neg_literals[i - 1]};
+        for(c2dSize j = 0; j < 2; ++j) {
+            Lit* lit = lits[j];
+            c2dSize kept = 0;
+            for(c2dSize k = 0; k < lit->n_clauses; ++k)
+                if (!lit->clauses[k]->detached) lit->clauses[kept++] = lit->clauses[k];
+            if (kept == lit->n_clauses) continue;
+            lit->n_clauses = kept;
+            lit->clauses_buf_len = kept > 0 ? kept : 1;
+            lit->clauses = realloc(lit->clauses, sizeof(Clause*) * lit->clauses_buf_len);
+        }
+    }
+}
+
+/******************************************************************************
+ * Detecting at-most-k constraints (k > 1)
+ ******************************************************************************/
+
+//a clause of k+1 literals over distinct variables, as the sorted ids of the
+//negations of its literals (padded with NO_ID up to CARD_MAX_BOUND+1)
+#define NO_ID ((c2dSize)-1)
+
+typedef struct {
+    c2dSize ids[CARD_MAX_BOUND + 1];
+    Clause* clause;
+    BOOLEAN used;        //hyperedge already covered by a group
+} Hyperedge;
+
+//the hyperedges, sorted, with the hyperedges of each literal id
+typedef struct {
+    Hyperedge* edges;
+    c2dSize n_edges;
+    c2dSize* start;      //hyperedges of literal id are occ[start[id]..start[id+1]-1]
+    c2dSize* occ;
+} Hypergraph;
+
+//returns 1 if the hyperedge has k+1 ids
+static BOOLEAN has_size(const Hyperedge* edge, c2dSize k) {
+    return edge->ids[k] != NO_ID && (k == CARD_MAX_BOUND || edge->ids[k + 1] == NO_ID);
+}
+
+static int compare_hyperedges(const void* a, const void* b) {
+    const Hyperedge* x = a;
+    const Hyperedge* y = b;
+    for(c2dSize j = 0; j <= CARD_MAX_BOUND; ++j)
+        if (x->ids[j] != y->ids[j]) return x->ids[j] < y->ids[j] ? -1 : 1;
+    return 0;
+}
+
+//fills the hyperedge of a clause, returns 0 if the clause is not one
+static BOOLEAN make_hyperedge(Clause* clause, Hyperedge* edge, const SatState* sat_state) {
+    c2dSize size = clause->n_literals;
+    if (size < 3 || size > CARD_MAX_BOUND + 1) return 0;
+    for(c2dSize j = 1; j < size; ++j)
+        for(c2dSize i = 0; i < j; ++i)
+            if (clause->literals[i]->var == clause->literals[j]->var) return 0;
+    for(c2dSize j = 0; j <= CARD_MAX_BOUND; ++j) edge->ids[j] = NO_ID;
+    for(c2dSize j = 0; j < size; ++j) {
+        //insertion sort by id
+        c2dSize id = lit_id(sat_literal_complement(clause->literals[j]), sat_state);
+        c2dSize i = j;
+        while (i > 0 && edge->ids[i - 1] > id) {
+            edge->ids[i] = edge->ids[i - 1];
+            --i;
+        }
+        edge->ids[i] = id;
+    }
+    edge->clause = clause;
+    edge->used = 0;
+    return 1;
+}
+
+static void hypergraph_new(Hypergraph* graph, SatState* sat_state) {
+    c2dSize ids = 2 * sat_state->n + 1;
+    graph->edges = malloc(sizeof(Hyperedge) * (sat_state->m + 1));
+    graph->n_edges = 0;
+    for(c2dSize i = 0; i < sat_state->m; ++i)
+        if (make_hyperedge(sat_state->CNF_clauses[i], &graph->edges[graph->n_edges], sat_state))
+            ++graph->n_edges;
+    qsort(graph->edges, graph->n_edges, sizeof(Hyperedge), compare_hyperedges);
+    //clauses with the same literals (in any order) make one hyperedge: the copies
+    //after the first stay attached
+    c2dSize kept = 0;
+    for(c2dSize h = 0; h < graph->n_edges; ++h)
+        if (kept == 0 || compare_hyperedges(&graph->edges[kept - 1], &graph->edges[h]) != 0)
+            graph->edges[kept++] = graph->edges[h];
+    graph->n_edges = kept;
+
+    graph->start = calloc(ids + 1, sizeof(c2dSize));
+    for(c2dSize h = 0; h < graph->n_edges; ++h)
+        for(c2dSize j = 0; j <= CARD_MAX_BOUND && graph->edges[h].ids[j] != NO_ID; ++j)
+            ++graph->start[graph->edges[h].ids[j] + 1];
+    for(c2dSize id = 0; id < ids; ++id) graph->start[id + 1] += graph->start[id];
+    c2dSize* fill = malloc(sizeof(c2dSize) * ids);
+    memcpy(fill, graph->start, sizeof(c2dSize) * ids);
+    graph->occ = malloc(sizeof(c2dSize) * (graph->start[ids] + 1));
+    for(c2dSize h = 0; h < graph->n_edges; ++h)
+        for(c2dSize j = 0; j <= CARD_MAX_BOUND && graph->edges[h].ids[j] != NO_ID; ++j)
+            graph->occ[fill[graph->edges[h].ids[j]]++] = h;
+    free(fill);
+}
+
+static void hypergraph_free(Hypergraph* graph) {
+    free(graph->edges);
+    free(graph->start);
+    free(graph->occ);
+}
+
+//returns the hyperedge not covered yet over the ids group[subset[0..k-1]] and id
+//(if not NULL), or NULL if there is none
+static Hyperedge* find_hyperedge(Hypergraph* graph, const c2dSize* group, const c2dSize* subset,
+                                 c2dSize k, const c2dSize* id) {
+    Hyperedge key;
+    c2dSize size = 0;
+    for(c2dSize j = 0; j <= CARD_MAX_BOUND; ++j) key.ids[j] = NO_ID;
+    for(c2dSize j = 0; j <= k; ++j) {
+        c2dSize x = j < k ? group[subset[j]] : (id ? *id : NO_ID);
+        if (x == NO_ID) continue;
+        c2dSize i = size++;
+        while (i > 0 && key.ids[i - 1] > x) {
+            key.ids[i] = key.ids[i - 1];
+            --i;
+        }
+        key.ids[i] = x;
+    }
+    Hyperedge* edge = bsearch(&key, graph->edges, graph->n_edges, sizeof(Hyperedge),
+                              compare_hyperedges);
+    return edge != NULL && !edge->used ? edge : NULL;
+}
+
+//advances subset[0..k-1] to the next k of the positions 0..size-1 (in lexicographic
+//order), returns 0 if it was the last
+static BOOLEAN next_subset(c2dSize* subset, c2dSize k, c2dSize size) {
+    c2dSize j = k;
+    while (j > 0 && subset[j - 1] == size - k + j - 1) --j;
+    if (j == 0) return 0;
+    ++subset[j - 1];
+    for( ; j < k; ++j) subset[j] = subset[j - 1] + 1;
+    return 1;
+}
+
+//returns 1 if every k of the ids of group, together with id, make a hyperedge not
+//covered yet
+static BOOLEAN joins_group(Hypergraph* graph, const c2dSize* group, c2dSize size,
+                           c2dSize k, c2dSize id) {
+    c2dSize subset[CARD_MAX_BOUND];
+    for(c2dSize j = 0; j < k; ++j) subset[j] = j;
+    do {
+        if (find_hyperedge(graph, group, subset, k, &id) == NULL) return 0;
+    } while (next_subset(subset, k, size));
+    return 1;
+}
+
+//grows a group from hyperedge seed (of k+1 ids), adding an id whenever every k of
+//the group make a hyperedge with it (it is then found among the hyperedges of the
+//first k ids of seed)
+static c2dSize grow_group(const Hyperedge* seed, c2dSize k, Hypergraph* graph,
+                          c2dSize* group, BOOLEAN* member) {
+    c2dSize size = 0;
+    for(c2dSize j = 0; j <= k; ++j) {
+        group[size++] = seed->ids[j];
+        member[seed->ids[j]] = 1;
+    }
+    c2dSize first = seed->ids[0];
+    for(c2dSize i = graph->start[first]; i < graph->start[first + 1]; ++i) {
+        const Hyperedge* edge = &graph->edges[graph->occ[i]];
+        if (edge->used || !has_size(edge, k)) continue;
+        //the id of edge other than the first k ids of seed
+        c2dSize other = NO_ID;
+        c2dSize shared = 0;
+        for(c2dSize j = 0; j <= k; ++j) {
+            c2dSize x = edge->ids[j];
+            BOOLEAN in_seed = 0;
+            for(c2dSize s = 0; s < k; ++s) in_seed |= seed->ids[s] == x;
+            if (in_seed) ++shared;
+            else other = x;
+        }
+        if (shared != k || member[other] || !joins_group(graph, group, size, k, other)) continue;
+        group[size++] = other;
+        member[other] = 1;
+    }
+    return size;
+}
+
+//marks the hyperedges over every k+1 ids of a group as covered, and detaches their clauses
+static c2dSize cover_group(const c2dSize* group, c2dSize size, c2dSize k, Hypergraph* graph) {
+    c2dSize n_detached = 0;
+    c2dSize subset[CARD_MAX_BOUND + 1];
+    for(c2dSize j = 0; j <= k; ++j) subset[j] = j;
+    do {
+        Hyperedge* edge = find_hyperedge(graph, group, subset, k + 1, NULL);
+        if (edge == NULL) continue; //covered already
+        edge->used = 1;
+        if (!edge->clause->detached) {
+            edge->clause->detached = 1;
+            ++n_detached;
+        }
+    } while (next_subset(subset, k + 1, size));
+    return n_detached;
+}
+
+/******************************************************************************
+ * Constructing the constraints
+ ******************************************************************************/
+
+//recovers the at-most-k constraints encoded by clauses of the cnf
+//returns NULL if there are none
+CardSet* card_set_new(SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    Graph graph;
+    graph_new(&graph, sat_state);
+    Hypergraph hypergraph;
+    hypergraph_new(&hypergraph, sat_state);
+
+    c2dSize n_edges = graph.start[2 * n + 1];
+    c2dSize n_hyperedges = hypergraph.n_edges;
+    Lit** clique = malloc(sizeof(Lit*) * (2 * n + 1));
+    Lit** touched = malloc(sizeof(Lit*) * (2 * n + 1));
+    c2dSize* count = calloc(2 * n + 1, sizeof(c2dSize));
+    BOOLEAN* member = calloc(2 * n + 1, sizeof(BOOLEAN));
+    //a clique of size k >= 3 covers k(k-1)/2 >= k edges, each of which is stored twice,
+    //and a group of size s >= b+2 covers at least s hyperedges
+    c2dSize* start = malloc(sizeof(c2dSize) * (n_edges / 2 + n_hyperedges + 1));
+    c2dSize* bound = malloc(sizeof(c2dSize) * (n_edges / 2 + n_hyperedges + 1));
+    Lit** lits = malloc(sizeof(Lit*) * (n_edges + n_hyperedges + 1));
+    c2dSize n_cards = 0;
+    c2dSize n_lits = 0;
+    c2dSize n_detached = 0;
+
+    for(c2dSize id = 0; id <= 2 * n; ++id) {
+        if (id == n) continue;
+        Lit* first = sat_index2literal((c2dLiteral)id - (c2dLiteral)n, sat_state);
+        while (1) {
+            c2dSize size = grow_clique(first, &graph, clique, count, member, touched, sat_state);
+            if (size >= CARD_MIN_SIZE) {
+                n_detached += cover_clique(clique, size, &graph, member, sat_state);
+                bound[n_cards] = 1;
+                start[n_cards++] = n_lits;
+                for(c2dSize k = 0; k < size; ++k) lits[n_lits++] = clique[k];
+            }
+            for(c2dSize k = 0; k < size; ++k) member[lit_id(clique[k], sat_state)] = 0;
+            if (size < CARD_MIN_SIZE) break;
+        }
+    }
+    graph_free(&graph);
+
+    c2dSize* group = malloc(sizeof(c2dSize) * (2 * n + 1));
+    for(c2dSize k = 2; k <= CARD_MAX_BOUND; ++k)
+        for(c2dSize h = 0; h < n_hyperedges; ++h) {
+            const Hyperedge* seed = &hypergraph.edges[h];
+            if (seed->used || !has_size(seed, k)) continue;
+            c2dSize size = grow_group(seed, k, &hypergraph, group, member);
+            for(c2dSize j = 0; j < size; ++j) member[group[j]] = 0;
+            if (size < k + 2) continue;
+            n_detached += cover_group(group, size, k, &hypergraph);
+            bound[n_cards] = k;
+            start[n_cards++] = n_lits;
+            for(c2dSize j = 0; j < size; ++j)
+                lits[n_lits++] = sat_index2literal((c2dLiteral)group[j] - (c2dLiteral)n, sat_state);
+        }
+    free(clique);
+    free(touched);
+    free(count);
+    free(member);
+    free(group);
+    hypergraph_free(&hypergraph);
+
+    if (n_cards == 0) {
+        free(start);
+        free(bound);
+        free(lits);
+        return NULL;
+    }
+    detach_clauses(sat_state);
+
+    CardSet* set = malloc(sizeof(CardSet));
+    set->n_cards = n_cards;
+    set->start = realloc(start, sizeof(c2dSize) * (n_cards + 1));
+    set->start[n_cards] = n_lits;
+    set->lits = realloc(lits, sizeof(Lit*) * n_lits);
+    set->bound = realloc(bound, sizeof(c2dSize) * n_cards);
+    set->n_true = calloc(n_cards, sizeof(c2dSize));
+    set->n_detached = n_detached;
+    set->n = n;
+
+    //occurrences of literals in constraints
+    set->occ_start = calloc(2 * n + 2, sizeof(c2dSize));
+    for(c2dSize i = 0; i < n_lits; ++i) ++set->occ_start[lit_id(set->lits[i], sat_state) + 1];
+    for(c2dSize id = 0; id <= 2 * n; ++id) set->occ_start[id + 1] += set->occ_start[id];
+    c2dSize* fill = malloc(sizeof(c2dSize) * (2 * n + 1));
+    memcpy(fill, set->occ_start, sizeof(c2dSize) * (2 * n + 1));
+    set->occ = malloc(sizeof(c2dSize) * n_lits);
+    for(c2dSize c = 0; c < n_cards; ++c)
+        for(c2dSize i = set->start[c]; i < set->start[c + 1]; ++i)
+            set->occ[fill[lit_id(set->lits[i], sat_state)]++] = c;
+    free(fill);
+
+    c2dSize longest = 0;
+    for(c2dSize c = 0; c < n_cards; ++c)
+        if (set->start[c + 1] - set->start[c] > longest) longest = set->start[c + 1] - set->start[c];
+    set->literals = malloc(sizeof(Lit*) * (longest + 1));
+    memset(&set->reason, 0, sizeof(Clause));
+    set->reason.literals = set->literals;
+    set->reason.assertion_level = 1;
+    return set;
+}
+
+//returns a copy of the constraints over the literals of sat state (a clone of the
+//sat state the constraints were recovered from)
+CardSet* card_set_clone(const CardSet* set, const SatState* sat_state) {
+    if (set == NULL) return NULL;
+    c2dSize n_cards = set->n_cards;
+    c2dSize n_lits = set->start[n_cards];
+    c2dSize n_ids = 2 * set->n + 2;
+    CardSet* copy = malloc(sizeof(CardSet));
+    *copy = *set;
+    copy->start = malloc(sizeof(c2dSize) * (n_cards + 1));
+    copy->lits = malloc(sizeof(Lit*) * n_lits);
+    copy->bound = malloc(sizeof(c2dSize) * n_cards);
+    copy->n_true = malloc(sizeof(c2dSize) * n_cards);
+    copy->occ_start = malloc(sizeof(c2dSize) * n_ids);
+    copy->occ = malloc(sizeof(c2dSize) * n_lits);
+    memcpy(copy->start, set->start, sizeof(c2dSize) * (n_cards + 1));
+    for(c2dSize i = 0; i < n_lits; ++i)
+        copy->lits[i] = sat_index2literal(sat_literal_index(set->lits[i]), sat_state);
+    memcpy(copy->bound, set->bound, sizeof(c2dSize) * n_cards);
+    memcpy(copy->n_true, set->n_true, sizeof(c2dSize) * n_cards);
+    memcpy(copy->occ_start, set->occ_start, sizeof(c2dSize) * n_ids);
+    memcpy(copy->occ, set->occ, sizeof(c2dSize) * n_lits);
+
+    c2dSize longest = 0;
+    for(c2dSize c = 0; c < n_cards; ++c)
+        if (set->start[c + 1] - set->start[c] > longest) longest = set->start[c + 1] - set->start[c];
+    copy->literals = malloc(sizeof(Lit*) * (longest + 1));
+    copy->reason.literals = copy->literals;
+    copy->reason.n_literals = 0;
+    return copy;
+}
+
+void card_set_free(CardSet* set) {
+    if (set) {
+        free(set->start);
+        free(set->lits);
+        free(set->bound);
+        free(set->n_true);
+        free(set->occ_start);
+        free(set->occ);
+        free(set->literals);
+        free(set);
+    }
+}
+
+//returns the number of cardinality constraints recovered from the cnf
+c2dSize sat_card_count(const SatState* sat_state) {
+    return sat_state->card_set ? sat_state->card_set->n_cards : 0;
+}
+
+//returns the number of cnf clauses replaced by cardinality constraints
+c2dSize sat_card_detached_count(const SatState* sat_state) {
+    return sat_state->card_set ? sat_state->card_set->n_detached : 0;
+}
+
+/******************************************************************************
+ * Counter-based propagation
+ ******************************************************************************/
+
+//adds x to the number of true literals of the constraints mentioning lit
+//(called when lit is set to true, with x=1, and when it is unset, with x=-1)
+void card_count(Lit* lit, SatState* sat_state, c2dLiteral x) {
+    CardSet* set = sat_state->card_set;
+    if (lit->var->index > set->n) return;
+    c2dSize id = lit->index + set->n;
+    for(c2dSize i = set->occ_start[id]; i < set->occ_start[id + 1]; ++i)
+        set->n_true[set->occ[i]] += x;
+}
+
+//fills the explaining clause of constraint c: the negations of its first
+//bound+1 true literals (conflict), or of its true literals and implied (implication)
+static Clause* explain(c2dSize c, Lit* implied, SatState* sat_state) {
+    CardSet* set = sat_state->card_set;
+    c2dSize n = 0;
+    if (implied) set->literals[n++] = implied;
+    for(c2dSize i = set->start[c]; i < set->start[c + 1] && n <= set->bound[c]; ++i)
+        if (sat_implied_literal(set->lits[i]))
+            set->literals[n++] = sat_literal_complement(set->lits[i]);
+    set->reason.n_literals = n;
+    return &set->reason;
+}
+
+//propagates the constraints mentioning lit, which has just been set to true
+//returns a clause whose literals are all false if a contradiction is found, NULL otherwise
+Clause* card_propagate(Lit* lit, SatState* sat_state) {
+    CardSet* set = sat_state->card_set;
+    if (lit->var->index > set->n) return NULL;
+    c2dSize id = lit->index + set->n;
+    for(c2dSize i = set->occ_start[id]; i < set->occ_start[id + 1]; ++i) {
+        c2dSize c = set->occ[i];
+        if (set->n_true[c] < set->bound[c]) continue;
+        if (set->n_true[c] > set->bound[c]) return explain(c, NULL, sat_state);
+        for(c2dSize j = set->start[c]; j < set->start[c + 1]; ++j) {
+            Lit* other = set->lits[j];
+            if (sat_instantiated_var(other->var)) continue;
+            Lit* implied = sat_literal_complement(other);
+            imply_literal(implied, explain(c, implied, sat_state), sat_state);
+            Clause* conflict = unit_resolution_helper(other, sat_state);
+            if (conflict != NULL) return conflict;
+        }
+    }
+    return NULL;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
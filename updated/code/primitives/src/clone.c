@@ -0,0 +1,211 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Cloning a sat state
+ *
+ * A clone is built from the sat state in memory, without reading the cnf file
+ * again: its variables, literals and clauses (cnf and learned) are copied with
+ * their current setting, and the pointers between them are mapped to the clone
+ * through indices:
+ * --a literal to the literal of the clone with the same index
+ * --a cnf clause to the clone's clause with the same index, and a learned clause
+ *   to the clone's learned clause at the same position
+ * --a node of the trail to the node at the same position
+ *
+ * The cnf clauses are copied too, since the clauses of the clone must point to its
+ * own literals (see formula.c): a clone takes time and memory linear in the size of
+ * the cnf and of the learned clauses, about as much as a new sat state, and only
+ * saves reading and parsing the file. Sharing the cnf clauses between clones would
+ * take the search data out of literals and clauses first, which is not done.
+ *
+ * The clone shares only the formula of the sat state (if it holds one), which is
+ * never changed, so each can be used on its own thread. Its copies of the XOR and
+ * cardinality constraints and of the clauses removed by variable elimination come
+ * from their modules (xor_matrix_clone(), card_set_clone() and elim_stack_clone()).
+ ******************************************************************************/
+
+//copies an array of count elements of the given size (NULL if count is 0)
+static void* copy_array(const void* array, c2dSize count, size_t size) {
+    if (count == 0) return NULL;
+    void* copy = malloc(size * count);
+    memcpy(copy, array, size * count);
+    return copy;
+}
+
+static Lit* map_literal(const Lit* lit, const SatState* clone) {
+    return lit ? sat_index2literal(sat_literal_index(lit), clone) : NULL;
+}
+
+//returns the clause of the clone corresponding to the clause of sat state, or NULL
+//for the explaining clauses of XOR and cardinality constraints (and for clauses
+//learned earlier but never asserted)
+static Clause* map_clause(const Clause* clause, const SatState* sat_state, const SatState* clone) {
+    if (clause == NULL) return NULL;
+    if (clause == sat_state->empty_clause) return clone->empty_clause;
+    c2dSize index = clause->index;
+    c2dSize m = sat_state->m;
+    if (index >= 1 && index <= m && sat_state->CNF_clauses[index - 1] == clause)
+        return clone->CNF_clauses[index - 1];
+    if (index > m && index <= m + sat_state->n_learned_clauses &&
+        sat_state->learned_clauses[index - m - 1] == clause)
+        return clone->learned_clauses[index - m - 1];
+    if (clause == sat_state->asserted_clause) return clone->asserted_clause;
+    return NULL;
+}
+
+//copies a clause of sat state, without its place in the occurrence lists
+static Clause* copy_clause(const Clause* clause, const SatState* clone) {
+    Clause* copy = malloc(sizeof(Clause));
+    *copy = *clause;
+    copy->literals = clause->n_literals ? malloc(sizeof(Lit*) * clause->n_literals) : NULL;
+    for(c2dSize i = 0; i < clause->n_literals; ++i)
+        copy->literals[i] = map_literal(clause->literals[i], clone);
+    copy->watch_lit1 = map_literal(clause->watch_lit1, clone);
+    copy->watch_lit2 = map_literal(clause->watch_lit2, clone);
+    return copy;
+}
+
+//maps the occurrence list of sat state with *count clauses to the clone, leaving out
+//the clauses the clone does not have (an empty list stays unallocated)
+static Clause** copy_clauses(Clause** clauses, c2dIndex* count, c2dIndex* buf_len,
+                             const SatState* sat_state, const SatState* clone) {
+    *buf_len = *count;
+    if (*count == 0) return NULL;
+    Clause** copy = malloc(sizeof(Clause*) * *count);
+    c2dSize kept = 0;
+    for(c2dSize i = 0; i < *count; ++i) {
+        copy[kept] = map_clause(clauses[i], sat_state, clone);
+        if (copy[kept] != NULL) ++kept;
+    }
+    *count = kept;
+    return copy;
+}
+
+static void copy_literal(const Lit* lit, Lit* copy, const SatState* sat_state, const SatState* clone) {
+    copy->decision_level = lit->decision_level;
+    copy->n_implied_by = lit->n_implied_by;
+    copy->implied_by_buf_len = lit->n_implied_by;
+    copy->implied_by = NULL;
+    if (lit->n_implied_by) {
+        copy->implied_by = malloc(sizeof(Lit*) * lit->n_implied_by);
+        for(c2dSize i = 0; i < lit->n_implied_by; ++i)
+            copy->implied_by[i] = map_literal(lit->implied_by[i], clone);
+    }
+    copy->reason = map_clause(lit->reason, sat_state, clone);
+    copy->n_clauses = lit->n_clauses;
+    copy->clauses = copy_clauses(lit->clauses, &copy->n_clauses, &copy->clauses_buf_len,
+                                 sat_state, clone);
+}
+
+//copies the trail: the implied literals in order, and each decision once the
+//trail is copied up to its mark
+static void copy_trail(const SatState* sat_state, SatState* clone) {
+    LitNode* decision = sat_state->decided_literals;
+    while (decision != NULL && decision->prev != NULL) decision = decision->prev;
+    LitNode* node = sat_state->implied_literals;
+    while (node != NULL && node->prev != NULL) node = node->prev;
+
+    LitNode* last = NULL;           //copy of the node before node
+    LitNode* last_decision = NULL;
+    while (1) {
+        //the marks come in the order of the decisions, as the trail is only appended to
+        LitNode* mark = node ? node->prev : sat_state->implied_literals;
+        for( ; decision != NULL && decision->trail == mark; decision = decision->next) {
+            LitNode* copy = trail_node_new(map_literal(decision->literal, clone), last_decision, clone);
+            copy->trail = last;
+            if (last_decision != NULL) last_decision->next = copy;
+            last_decision = copy;
+        }
+        if (node == NULL) break;
+        LitNode* copy = trail_node_new(map_literal(node->literal, clone), last, clone);
+        if (last != NULL) last->next = copy;
+        last = copy;
+        node = node->next;
+    }
+    assert(decision == NULL);
+    clone->implied_literals = last;
+    clone->decided_literals = last_decision;
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//returns a copy of sat state, which can be used (and freed) independently of it
+SatState* sat_state_clone(const SatState* sat_state) {
+    SatState* clone = malloc(sizeof(SatState));
+    *clone = *sat_state;
+    c2dSize n = sat_state->n;
+    c2dSize m = sat_state->m;
+
+    clone->variables = malloc(sizeof(Var*) * n);
+    clone->pos_literals = malloc(sizeof(Lit*) * n);
+    clone->neg_literals = malloc(sizeof(Lit*) * n);
+    for(c2dSize i = 1; i <= n; ++i) {
+        Var* var = Var_new(i);
+        Lit* pos = Lit_new((c2dLiteral)i);
+        Lit* neg = Lit_new(-(c2dLiteral)i);
+        var->pos_literal = pos;
+        var->neg_literal = neg;
+        pos->var = var;
+        neg->var = var;
+        clone->variables[i - 1] = var;
+        clone->pos_literals[i - 1] = pos;
+        clone->neg_literals[i - 1] = neg;
+    }
+
+    clone->CNF_clauses = malloc(sizeof(Clause*) * m);
+    for(c2dSize i = 0; i < m; ++i)
+        clone->CNF_clauses[i] = copy_clause(sat_state->CNF_clauses[i], clone);
+    clone->learned_clauses = sat_state->learned_clauses_buf_len ?
+        malloc(sizeof(Clause*) * sat_state->learned_clauses_buf_len) : NULL;
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses; ++i)
+        clone->learned_clauses[i] = copy_clause(sat_state->learned_clauses[i], clone);
+    clone->empty_clause = sat_state->empty_clause ? copy_clause(sat_state->empty_clause, clone) : NULL;
+    //a clause learned from a contradiction may not be among the learned clauses yet
+    clone->asserted_clause = NULL;
+    if (sat_state->asserted_clause != NULL) {
+        clone->asserted_clause = map_clause(sat_state->asserted_clause, sat_state, clone);
+        if (clone->asserted_clause == NULL)
+            clone->asserted_clause = copy_clause(sat_state->asserted_clause, clone);
+    }
+
+    for(c2dSize i = 0; i < n; ++i) {
+        Var* var = sat_state->variables[i];
+        Var* copy = clone->variables[i];
+        copy->n_clauses = var->n_clauses;
+        copy->clauses = copy_clauses(var->clauses, &copy->n_clauses, &copy->clauses_buf_len,
+                                     sat_state, clone);
+        copy->phase = var->phase;
+        copy->mark = var->mark;
+        copy_literal(sat_state->pos_literals[i], clone->pos_literals[i], sat_state, clone);
+        copy_literal(sat_state->neg_literals[i], clone->neg_literals[i], sat_state, clone);
+    }
+    clone->free_nodes = NULL; //the trail of the clone is carved from blocks of its own
+    clone->node_slabs = NULL;
+    copy_trail(sat_state, clone);
+
+    clone->failed_assumptions = NULL;
+    if (sat_state->failed_assumptions) {
+        clone->failed_assumptions = malloc(sizeof(Lit*) * (sat_state->n_failed_assumptions + 1));
+        for(c2dSize i = 0; i < sat_state->n_failed_assumptions; ++i)
+            clone->failed_assumptions[i] = map_literal(sat_state->failed_assumptions[i], clone);
+    }
+    clone->model = copy_array(sat_state->model, n + 1, sizeof(BOOLEAN));
+    clone->xor_matrix = xor_matrix_clone(sat_state->xor_matrix);
+    clone->card_set = card_set_clone(sat_state->card_set, clone);
+    clone->elim_stack = elim_stack_clone(sat_state->elim_stack);
+    clone->proof = NULL; //a proof is written by one sat state
+    clone->saved_trail = sat_state->saved_trail ? saved_trail_new() : NULL;
+    clone->formula = sat_state->formula ? formula_retain(sat_state->formula) : NULL;
+    clone->seen = NULL; //the conflict analysis arrays are allocated on first use
+    clone->marked_lits = NULL;
+    clone->analysis_lits = NULL;
+    clone->resolved = NULL;
+    clone->analysis_n = 0;
+    return clone;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,193 @@
+#include <pthread.h>
+#include "sat_api.h"
+
+/******************************************************************************
+ * Formulas
+ *
+ * A formula is a cnf as literal indices, one clause after the other, never
+ * changed once made. sat_state_new() reads the file into a formula, builds the
+ * clauses of the sat state from it and frees it. Formulas are reference counted
+ * (clones hold the formula of their sat state, and may be freed on other threads).
+ *
+ * Formulas do not share a cnf between searches: each sat state has its own
+ * variables, literals and clauses, as the API reads the setting of a literal
+ * (sat_implied_literal()) and the marks of a clause from the structure alone.
+ *
+ * A sat state keeps no formula at first. Before its cnf is first changed (by
+ * preprocessing, symmetry breaking or added clauses and variables), the cnf is
+ * captured into a formula (formula_capture()), which sat_state_reset() goes back
+ * to; until then, its clauses are the formula.
+ ******************************************************************************/
+
+struct formula {
+    c2dSize n;              //number of variables
+    c2dSize m;              //number of clauses
+    c2dLiteral* literals;   //the literals of the clauses, in order
+    c2dSize* start;         //clause i (from 0) is literals[start[i]] to literals[start[i+1]-1]
+    c2dSize n_refs;         //references held by sat states and callers
+    pthread_mutex_t lock;   //guards n_refs, as sat states may be freed by different threads
+};
+
+static char* read_next_number(char* p, long* num) {
+    long sign = 1;
+    *num = 0;
+    while (*p && !(*p >= '0' && *p <= '9') && *p != '-') ++p;
+    if (*p == '-') {
+        sign = -1;
+        ++p;
+    }
+    while (*p >= '0' && *p <= '9') {
+        *num = *num * 10 + (*p - '0');
+        ++p;
+    }
+    *num = *num * sign;
+    return p;
+}
+
+//reads the cnf of a file into a formula
+//returns NULL if the file cannot be opened
+Formula* formula_read(const char* file_name) {
+    FILE* fp = fopen(file_name, "r");
+    if (fp == NULL) {
+        printf("Error: file %s cannot be open", file_name);
+        return NULL;
+    }
+    Formula* formula = malloc(sizeof(Formula));
+    formula->n = 0;
+    formula->m = 0;
+    formula->start = malloc(sizeof(c2dSize));
+    formula->start[0] = 0;
+    formula->literals = NULL;
+    formula->n_refs = 1;
+    pthread_mutex_init(&formula->lock, NULL);
+
+    char* line = malloc(sizeof(char) * (BUF_LEN + 5));
+    c2dLiteral tmp;
+    while (fgets(line, BUF_LEN, fp) != NULL) {
+        if (line[0] != 'p') continue;
+        char* p = read_next_number(line, &tmp);
+        formula->n = (c2dSize)tmp;
+        read_next_number(p, &tmp);
+        c2dSize m = (c2dSize)tmp;
+        formula->start = realloc(formula->start, sizeof(c2dSize) * (m + 1));
+        c2dSize buf_len = 4 * m + 1;
+        formula->literals = malloc(sizeof(c2dLiteral) * buf_len);
+        c2dSize size = 0;
+        //a line holds a clause: lines without literals are skipped
+        while (formula->m < m && fgets(line, BUF_LEN, fp) != NULL) {
+            p = line;
+            c2dSize n_literals = 0;
+            while (1) {
+                p = read_next_number(p, &tmp);
+                if (tmp == 0) break;
+                if (size == buf_len) {
+                    buf_len *= 2;
+                    formula->literals = realloc(formula->literals, sizeof(c2dLiteral) * buf_len);
+                }
+                formula->literals[size++] = tmp;
+                ++n_literals;
+            }
+            if (n_literals > 0) formula->start[++formula->m] = size;
+        }
+        break;
+    }
+    free(line);
+    fclose(fp);
+    return formula;
+}
+
+//holds one more reference to the formula
+Formula* formula_retain(Formula* formula) {
+    pthread_mutex_lock(&formula->lock);
+    ++formula->n_refs;
+    pthread_mutex_unlock(&formula->lock);
+    return formula;
+}
+
+//releases a reference to the formula, which is freed with the last one
+void formula_release(Formula* formula) {
+    if (formula == NULL) return;
+    pthread_mutex_lock(&formula->lock);
+    c2dSize n_refs = --formula->n_refs;
+    pthread_mutex_unlock(&formula->lock);
+    if (n_refs > 0) return;
+    pthread_mutex_destroy(&formula->lock);
+    free(formula->literals);
+    free(formula->start);
+    free(formula);
+}
+
+c2dSize formula_var_count(const Formula* formula) {
+    return formula->n;
+}
+
+c2dSize formula_clause_count(const Formula* formula) {
+    return formula->m;
+}
+
+//returns the literals of the index^th clause (from 0), and their number in size
+const c2dLiteral* formula_clause(c2dSize index, c2dSize* size, const Formula* formula) {
+    *size = formula->start[index + 1] - formula->start[index];
+    return formula->literals + formula->start[index];
+}
+
+//returns a new formula holding the cnf clauses of sat state, in order
+static Formula* formula_of_clauses(const SatState* sat_state) {
+    Formula* formula = malloc(sizeof(Formula));
+    formula->n = sat_state->n;
+    formula->m = sat_state->m;
+    formula->start = malloc(sizeof(c2dSize) * (sat_state->m + 1));
+    formula->start[0] = 0;
+    for(c2dSize i = 0; i < sat_state->m; ++i)
+        formula->start[i + 1] = formula->start[i] + sat_state->CNF_clauses[i]->n_literals;
+    formula->literals = malloc(sizeof(c2dLiteral) * (formula->start[sat_state->m] + 1));
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        const Clause* clause = sat_state->CNF_clauses[i];
+        for(c2dSize j = 0; j < clause->n_literals; ++j)
+            formula->literals[formula->start[i] + j] = (c2dLiteral)clause->literals[j]->index;
+    }
+    formula->n_refs = 1;
+    pthread_mutex_init(&formula->lock, NULL);
+    return formula;
+}
+
+//returns a reference to the formula of sat state, to be released by the caller
+//
+//a sat state without a formula has the cnf it was constructed with, which is then
+//read into a new formula
+Formula* formula_of_state(const SatState* sat_state) {
+    if (sat_state->formula != NULL) return formula_retain(sat_state->formula);
+    return formula_of_clauses(sat_state);
+}
+
+//makes sure sat state holds its formula, before its cnf is changed
+void formula_capture(SatState* sat_state) {
+    if (sat_state->formula == NULL) sat_state->formula = formula_of_clauses(sat_state);
+}
+
+//adds the 8 bytes of value to an FNV-1a hash
+static unsigned long long fnv_add(unsigned long long hash, unsigned long long value) {
+    for(int i = 0; i < 8; ++i) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//returns the 64-bit FNV-1a hash of the numbers of variables and clauses of the
+//formula, and of each clause (its size, then its literals)
+unsigned long long formula_hash(const Formula* formula) {
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = fnv_add(hash, formula->n);
+    hash = fnv_add(hash, formula->m);
+    for(c2dSize i = 0; i < formula->m; ++i) {
+        hash = fnv_add(hash, formula->start[i + 1] - formula->start[i]);
+        for(c2dSize j = formula->start[i]; j < formula->start[i + 1]; ++j)
+            hash = fnv_add(hash, (unsigned long long)(long long)formula->literals[j]);
+    }
+    return hash;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,157 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Adding and removing clauses
+ *
+ * Clauses are added to the cnf of a sat state at decision level 1, after its
+ * other cnf clauses: the learned clauses, numbered after the cnf clauses, move up
+ * by one. A new clause is set against the literals implied at level 1 like any
+ * other (see Clause_new()), and unit resolution runs at once if it is unit, or
+ * false, under them.
+ *
+ * A removable clause is added with a new activation variable a, as the clause
+ * or -a: it constrains the search only when a is assumed (see
+ * sat_solve_assuming()). No clause mentions a otherwise, so every clause learned
+ * from it contains -a too. Removing it replaces it with the unit clause -a: the
+ * clauses learned from it are then satisfied, and are removed, while the other
+ * learned clauses, which do not depend on it, are kept.
+ ******************************************************************************/
+
+//adds variables n+1..new_n to sat state
+void extend_vars(c2dSize new_n, SatState* sat_state) {
+    formula_capture(sat_state);
+    c2dSize n = sat_state->n;
+    sat_state->variables = realloc(sat_state->variables, sizeof(Var*) * new_n);
+    sat_state->pos_literals = realloc(sat_state->pos_literals, sizeof(Lit*) * new_n);
+    sat_state->neg_literals = realloc(sat_state->neg_literals, sizeof(Lit*) * new_n);
+    for(c2dSize i = n + 1; i <= new_n; ++i) {
+        sat_state->variables[i - 1] = Var_new(i);
+        sat_state->pos_literals[i - 1] = Lit_new((c2dLiteral)i);
+        sat_state->neg_literals[i - 1] = Lit_new(-((c2dLiteral)i));
+        sat_state->variables[i - 1]->pos_literal = sat_state->pos_literals[i - 1];
+        sat_state->variables[i - 1]->neg_literal = sat_state->neg_literals[i - 1];
+        sat_state->pos_literals[i - 1]->var = sat_state->variables[i - 1];
+        sat_state->neg_literals[i - 1]->var = sat_state->variables[i - 1];
+    }
+    sat_state->model = realloc(sat_state->model, sizeof(BOOLEAN) * (new_n + 1));
+    memset(sat_state->model + n + 1, 0, sizeof(BOOLEAN) * (new_n - n));
+    sat_state->n = new_n;
+}
+
+//adds a clause with the given literals as the last cnf clause
+static Clause* add_cnf_clause(Lit** literals, c2dSize size, SatState* sat_state) {
+    formula_capture(sat_state);
+    c2dSize m = ++sat_state->m;
+    sat_state->extended = 1;
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses; ++i)
+        sat_state->learned_clauses[i]->index = m + i + 1;
+    sat_state->CNF_clauses = realloc(sat_state->CNF_clauses, sizeof(Clause*) * m);
+    sat_state->CNF_clauses[m - 1] = Clause_new(m, literals, size, m);
+    return sat_state->CNF_clauses[m - 1];
+}
+
+//runs unit resolution from clause, if it is unit or false at level 1
+//returns 0 if a contradiction is found (after constructing an asserting clause), 1 otherwise
+static BOOLEAN propagate_clause(Clause* clause, SatState* sat_state) {
+    if (sat_subsumed_clause(clause)) return 1;
+    Clause* conflict = NULL;
+    if ((c2dSize)clause->n_false == clause->n_literals) conflict = clause;
+    else if ((c2dSize)clause->n_false + 1 == clause->n_literals) {
+        Lit* unset_lit = NULL;
+        for(c2dSize i = 0; i < clause->n_literals && unset_lit == NULL; ++i)
+            if (!sat_instantiated_var(clause->literals[i]->var)) unset_lit = clause->literals[i];
+        imply_literal(unset_lit, clause, sat_state);
+        conflict = unit_resolution_helper(sat_index2literal(-unset_lit->index, sat_state), sat_state);
+        if (conflict == NULL && sat_state->xor_matrix != NULL) conflict = xor_propagate(sat_state);
+    }
+    if (conflict == NULL) return 1;
+    sat_state->asserted_clause = construct_asserted_clause(conflict, sat_state);
+    return 0;
+}
+
+//removes clause from the occurrence list of lit, or of var
+static void drop_occurrence(Clause* clause, Clause** clauses, c2dIndex* count) {
+    for(c2dSize i = 0; i < *count; ++i)
+        if (clauses[i] == clause) {
+            clauses[i] = clauses[--*count];
+            return;
+        }
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//adds a new variable to sat state, and returns its index
+c2dSize sat_add_var(SatState* sat_state) {
+    extend_vars(sat_state->n + 1, sat_state);
+    return sat_state->n;
+}
+
+//adds the clause with the given literals to the cnf of sat state
+//returns 0 if unit resolution then finds a contradiction, 1 otherwise
+BOOLEAN sat_add_clause(const c2dLiteral* lits, c2dSize size, SatState* sat_state) {
+    assert(sat_state->current_level == 1 && size > 0);
+    assert(sat_state->proof == NULL && sat_state->elim_stack == NULL);
+    Lit** literals = malloc(sizeof(Lit*) * size);
+    for(c2dSize i = 0; i < size; ++i) literals[i] = sat_index2literal(lits[i], sat_state);
+    return propagate_clause(add_cnf_clause(literals, size, sat_state), sat_state);
+}
+
+//adds the clause with the given literals to the cnf of sat state, together with
+//a new activation variable, and returns the activation literal
+c2dLiteral sat_add_removable_clause(const c2dLiteral* lits, c2dSize size, SatState* sat_state) {
+    assert(sat_state->current_level == 1);
+    assert(sat_state->proof == NULL && sat_state->elim_stack == NULL);
+    c2dLiteral activation = (c2dLiteral)sat_add_var(sat_state);
+    Lit** literals = malloc(sizeof(Lit*) * (size + 1));
+    for(c2dSize i = 0; i < size; ++i) literals[i] = sat_index2literal(lits[i], sat_state);
+    literals[size] = sat_index2literal(-activation, sat_state);
+    //the clause can only imply -a, when its other literals are false at level 1
+    propagate_clause(add_cnf_clause(literals, size + 1, sat_state), sat_state);
+    return activation;
+}
+
+//removes the clause added with the activation literal
+//returns 0 if unit resolution then finds a contradiction, 1 otherwise
+BOOLEAN sat_remove_clause(c2dLiteral activation, SatState* sat_state) {
+    assert(sat_state->current_level == 1);
+    Var* var = sat_index2var((c2dSize)activation, sat_state);
+    Lit* off = var->neg_literal;
+    assert(var->n_clauses == 1 && !sat_implied_literal(var->pos_literal));
+    Clause* clause = var->clauses[0];
+    assert(!clause->detached);
+    trail_forget(sat_state);
+
+    //the learned clauses containing -a
+    c2dSize m = sat_state->m;
+    Clause** learned = malloc(sizeof(Clause*) * (off->n_clauses + 1));
+    c2dSize count = 0;
+    for(c2dSize i = 0; i < off->n_clauses; ++i) {
+        Clause* other = off->clauses[i];
+        c2dSize index = other->index;
+        if (index > m && index <= m + sat_state->n_learned_clauses &&
+            sat_state->learned_clauses[index - m - 1] == other) learned[count++] = other;
+    }
+    remove_learned(learned, count, sat_state);
+    free(learned);
+
+    //the clause becomes the unit clause -a
+    for(c2dSize i = 0; i < clause->n_literals; ++i) {
+        Lit* lit = clause->literals[i];
+        if (lit == off) continue;
+        drop_occurrence(clause, lit->clauses, &lit->n_clauses);
+        drop_occurrence(clause, lit->var->clauses, &lit->var->n_clauses);
+    }
+    clause->literals[0] = off;
+    clause->n_literals = 1;
+    clause->n_false = 0;
+    clause->subsumed_level = sat_implied_literal(off) ? off->decision_level : 0;
+    clause->watch_lit1 = NULL;
+    clause->watch_lit2 = NULL;
+    return propagate_clause(clause, sat_state);
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
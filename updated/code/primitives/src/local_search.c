@@ -0,0 +1,220 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Stochastic local search (probSAT)
+ *
+ * The search works on a complete assignment of the variables, and repeatedly
+ * flips a variable of a randomly picked unsatisfied cnf clause. The variable is
+ * picked with a probability that decreases exponentially with its break count,
+ * which is the number of clauses that would become unsatisfied by the flip.
+ *
+ * For each cnf clause we keep the number of its true literals, together with the
+ * sum of the indices of the variables of those literals (when a single literal
+ * is true, this sum is the index of its variable). Break counts are maintained
+ * incrementally from these two numbers, and unsatisfied clauses are kept in a
+ * dense list (with the position of each clause in the list) so that picking and
+ * removing clauses takes constant time.
+ *
+ * Learned clauses are implied by the cnf clauses, so they are ignored here. The
+ * search keeps its own occurrence lists of cnf clauses, as the occurrence lists
+ * of literals also hold learned clauses and miss the clauses detached by
+ * cardinality constraints.
+ ******************************************************************************/
+
+#define CB        2.5 //base of the exponential break function
+#define MAX_BREAK 32  //break counts above this one share the same probability
+
+typedef struct {
+    BOOLEAN* value;       //value[i] is the value of variable i
+    BOOLEAN* fixed;       //fixed[i] is 1 if variable i is implied in the sat state
+    c2dSize* true_count;  //number of true literals in each cnf clause
+    c2dSize* crit_sum;    //sum of the variables of the true literals in each cnf clause
+    c2dSize* break_count; //break_count[i] is the break count of variable i
+    c2dSize* unsat;       //unsatisfied cnf clauses (positions in CNF_clauses)
+    c2dSize* unsat_pos;   //position of each unsatisfied clause in unsat
+    c2dSize* occ_start;   //cnf clauses of literal l are occ[occ_start[id]..occ_start[id+1]-1]
+    c2dSize* occ;         //(id is l->index + n, clauses are positions in CNF_clauses)
+    c2dSize n_unsat;
+    double prob[MAX_BREAK + 1];
+    unsigned long rng;
+} LocalSearch;
+
+//xorshift64* generator, so that runs are reproducible given a seed
+static unsigned long next_random(LocalSearch* ls) {
+    ls->rng ^= ls->rng >> 12;
+    ls->rng ^= ls->rng << 25;
+    ls->rng ^= ls->rng >> 27;
+    return ls->rng * 2685821657736338717UL;
+}
+
+static void add_unsat(c2dSize i, LocalSearch* ls) {
+    ls->unsat_pos[i] = ls->n_unsat;
+    ls->unsat[ls->n_unsat++] = i;
+}
+
+static void remove_unsat(c2dSize i, LocalSearch* ls) {
+    c2dSize last = ls->unsat[--ls->n_unsat];
+    ls->unsat[ls->unsat_pos[i]] = last;
+    ls->unsat_pos[last] = ls->unsat_pos[i];
+}
+
+//returns the literal id of variable v that is true in the current assignment
+static c2dSize true_literal(c2dSize v, LocalSearch* ls, SatState* sat_state) {
+    return ls->value[v] ? sat_state->n + v : sat_state->n - v;
+}
+
+static void occurrences_new(LocalSearch* ls, SatState* sat_state) {
+    c2dSize ids = 2 * sat_state->n + 1;
+    ls->occ_start = calloc(ids + 1, sizeof(c2dSize));
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        for(c2dSize j = 0; j < clause->n_literals; ++j)
+            ++ls->occ_start[clause->literals[j]->index + sat_state->n + 1];
+    }
+    for(c2dSize id = 0; id < ids; ++id) ls->occ_start[id + 1] += ls->occ_start[id];
+    c2dSize* fill = malloc(sizeof(c2dSize) * ids);
+    memcpy(fill, ls->occ_start, sizeof(c2dSize) * ids);
+    ls->occ = malloc(sizeof(c2dSize) * (ls->occ_start[ids] + 1));
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        for(c2dSize j = 0; j < clause->n_literals; ++j)
+            ls->occ[fill[clause->literals[j]->index + sat_state->n]++] = i;
+    }
+    free(fill);
+}
+
+//flips variable v, updating the counters of the cnf clauses mentioning it
+static void flip(c2dSize v, LocalSearch* ls, SatState* sat_state) {
+    c2dSize was_true = true_literal(v, ls, sat_state);
+    ls->value[v] = !ls->value[v];
+    c2dSize now_true = true_literal(v, ls, sat_state);
+
+    for(c2dSize j = ls->occ_start[now_true]; j < ls->occ_start[now_true + 1]; ++j) {
+        c2dSize i = ls->occ[j];
+        if (ls->true_count[i] == 0) {
+            remove_unsat(i, ls);
+            ++ls->break_count[v];
+        } else if (ls->true_count[i] == 1) {
+            --ls->break_count[ls->crit_sum[i]];
+        }
+        ++ls->true_count[i];
+        ls->crit_sum[i] += v;
+    }
+    for(c2dSize j = ls->occ_start[was_true]; j < ls->occ_start[was_true + 1]; ++j) {
+        c2dSize i = ls->occ[j];
+        --ls->true_count[i];
+        ls->crit_sum[i] -= v;
+        if (ls->true_count[i] == 0) {
+            add_unsat(i, ls);
+            --ls->break_count[v];
+        } else if (ls->true_count[i] == 1) {
+            ++ls->break_count[ls->crit_sum[i]];
+        }
+    }
+}
+
+//picks a variable of an unsatisfied clause to flip (0 if all its variables are fixed)
+static c2dSize pick_var(Clause* clause, LocalSearch* ls) {
+    double weights[clause->n_literals];
+    double sum = 0;
+    for(c2dSize j = 0; j < clause->n_literals; ++j) {
+        c2dSize v = clause->literals[j]->var->index;
+        c2dSize b = ls->break_count[v];
+        weights[j] = ls->fixed[v] ? 0 : ls->prob[b < MAX_BREAK ? b : MAX_BREAK];
+        sum += weights[j];
+    }
+    if (sum == 0) return 0;
+    double r = sum * ((next_random(ls) >> 11) * (1.0 / 9007199254740992.0));
+    for(c2dSize j = 0; j < clause->n_literals; ++j) {
+        if (weights[j] == 0) continue;
+        if (r < weights[j]) return clause->literals[j]->var->index;
+        r -= weights[j];
+    }
+    for(c2dSize j = clause->n_literals; j > 0; --j) //rounding
+        if (weights[j - 1] > 0) return clause->literals[j - 1]->var->index;
+    return 0;
+}
+
+//starts from the saved phases (implied literals keep their values)
+static void init_assignment(LocalSearch* ls, SatState* sat_state) {
+    c2dSize n = sat_var_count(sat_state);
+    for(c2dSize v = 1; v <= n; ++v) {
+        Var* var = sat_index2var(v, sat_state);
+        ls->fixed[v] = sat_instantiated_var(var);
+        ls->value[v] = ls->fixed[v] ? sat_implied_literal(sat_pos_literal(var))
+                                    : var->phase;
+        ls->break_count[v] = 0;
+    }
+    ls->n_unsat = 0;
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        ls->true_count[i] = 0;
+        ls->crit_sum[i] = 0;
+        for(c2dSize j = 0; j < clause->n_literals; ++j) {
+            Lit* lit = clause->literals[j];
+            if (ls->value[lit->var->index] == (lit->index > 0)) {
+                ++ls->true_count[i];
+                ls->crit_sum[i] += lit->var->index;
+            }
+        }
+        if (ls->true_count[i] == 0) add_unsat(i, ls);
+        else if (ls->true_count[i] == 1) ++ls->break_count[ls->crit_sum[i]];
+    }
+}
+
+//runs a probSAT local search over the cnf clauses for at most max_flips flips
+//returns 1 if a model is found, 0 otherwise
+BOOLEAN sat_local_search(c2dSize max_flips, unsigned long seed, SatState* sat_state) {
+    c2dSize n = sat_var_count(sat_state);
+    c2dSize m = sat_state->m;
+    LocalSearch ls;
+    ls.value       = malloc(sizeof(BOOLEAN) * (n + 1));
+    ls.fixed       = malloc(sizeof(BOOLEAN) * (n + 1));
+    ls.break_count = malloc(sizeof(c2dSize) * (n + 1));
+    ls.true_count  = malloc(sizeof(c2dSize) * (m + 1));
+    ls.crit_sum    = malloc(sizeof(c2dSize) * (m + 1));
+    ls.unsat       = malloc(sizeof(c2dSize) * (m + 1));
+    ls.unsat_pos   = malloc(sizeof(c2dSize) * (m + 1));
+    ls.rng         = seed ? seed : 1;
+    occurrences_new(&ls, sat_state);
+    ls.prob[0] = 1;
+    for(c2dSize b = 1; b <= MAX_BREAK; ++b) ls.prob[b] = ls.prob[b - 1] / CB;
+
+    init_assignment(&ls, sat_state);
+    BOOLEAN* best = malloc(sizeof(BOOLEAN) * (n + 1));
+    memcpy(best, ls.value, sizeof(BOOLEAN) * (n + 1));
+    c2dSize best_unsat = ls.n_unsat;
+
+    for(c2dSize flips = 0; ls.n_unsat > 0 && flips < max_flips; ++flips) {
+        c2dSize i = ls.unsat[next_random(&ls) % ls.n_unsat];
+        c2dSize v = pick_var(sat_state->CNF_clauses[i], &ls);
+        if (v == 0) continue; //all variables of the clause are fixed
+        flip(v, &ls, sat_state);
+        if (ls.n_unsat < best_unsat) {
+            best_unsat = ls.n_unsat;
+            memcpy(best, ls.value, sizeof(BOOLEAN) * (n + 1));
+        }
+    }
+
+    BOOLEAN found = ls.n_unsat == 0;
+    for(c2dSize v = 1; v <= n; ++v) {
+        sat_index2var(v, sat_state)->phase = best[v];
+        if (found) sat_state->model[v] = ls.value[v];
+    }
+
+    free(best);
+    free(ls.value);
+    free(ls.fixed);
+    free(ls.break_count);
+    free(ls.true_count);
+    free(ls.crit_sum);
+    free(ls.unsat);
+    free(ls.unsat_pos);
+    free(ls.occ_start);
+    free(ls.occ);
+    return found;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,95 @@
+#define _DEFAULT_SOURCE //for MAP_ANONYMOUS, MAP_HUGETLB and madvise()
+#include "sat_api.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/******************************************************************************
+ * Large tables
+ *
+ * Tables of at least HUGE_PAGE_SIZE bytes (the trail nodes of a sat state, the
+ * cache of c2D) are mapped from the kernel directly, aligned to huge pages, so
+ * that they can be backed by them:
+ * --transparent huge pages (the default): the mapping is marked with
+ *   madvise(MADV_HUGEPAGE), which the kernel honors when it has huge pages free
+ * --explicit huge pages: the mapping is taken from the pool of hugetlbfs pages
+ *   (MAP_HUGETLB), falling back to transparent huge pages when the pool is empty
+ * Smaller tables, and all tables on systems without mmap(), come from calloc().
+ *
+ * The pages of a mapping are not touched when it is made: each is zeroed by the
+ * kernel when it is first written to. Tables are not bound to NUMA nodes, so
+ * their pages are placed by the default policy of the kernel. Clauses and the
+ * entries of the c2D cache are allocated one by one with malloc(), as before.
+ ******************************************************************************/
+
+#define HUGE_PAGE_SIZE (2UL << 20) //2 MB, the huge page size of x86-64 and arm64
+
+static int page_mode = 1; //0: base pages, 1: transparent huge pages, 2: explicit huge pages
+
+#ifdef __linux__
+//returns a mapping of len bytes (a multiple of HUGE_PAGE_SIZE) aligned to a huge
+//page, or NULL
+static void* map_aligned(size_t len) {
+    char* raw = mmap(NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    char* start = (char*)(((unsigned long)raw + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    if (start > raw) munmap(raw, start - raw);
+    if (raw + HUGE_PAGE_SIZE > start) munmap(start + len, raw + HUGE_PAGE_SIZE - start);
+    return start;
+}
+#endif
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//sets how large tables allocated from now on are backed: 0 base pages only,
+//1 transparent huge pages (the default), 2 explicit huge pages
+void sat_set_huge_pages(int mode) {
+    page_mode = mode;
+}
+
+//returns a zeroed table of size bytes (NULL if memory is exhausted)
+void* sat_large_alloc(size_t size) {
+#ifdef __linux__
+    if (size >= HUGE_PAGE_SIZE) {
+        size_t len = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void* table = NULL;
+#ifdef MAP_HUGETLB
+        if (page_mode == 2) {
+            table = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (table == MAP_FAILED) table = NULL;
+        }
+#endif
+        if (table == NULL) {
+            table = map_aligned(len);
+#ifdef MADV_HUGEPAGE
+            if (table != NULL && page_mode > 0) madvise(table, len, MADV_HUGEPAGE);
+#endif
+        }
+#ifdef SAT_ALLOC_CHECK
+        if (table != NULL) alloc_counted(table);
+#endif
+        return table;
+    }
+#endif
+    return calloc(size, 1);
+}
+
+//frees a table of size bytes returned by sat_large_alloc()
+void sat_large_free(void* table, size_t size) {
+    if (table == NULL) return;
+#ifdef __linux__
+    if (size >= HUGE_PAGE_SIZE) {
+        munmap(table, (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+        return;
+    }
+#endif
+    free(table);
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
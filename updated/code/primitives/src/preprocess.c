@@ -0,0 +1,856 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Preprocessing (SatELite style)
+ *
+ * The cnf of a sat state is simplified before search by:
+ * --unit propagation at the top level
+ * --backward subsumption: a clause C removes every clause containing it
+ * --self-subsuming strengthening: if C = (l or R) and D = (-l or R'), with R a
+ *   subset of R', then -l is removed from D
+ * --equivalent literal substitution: literals on a cycle of binary clauses
+ *   (a strongly connected component of the implication graph) are equivalent,
+ *   and each is replaced by the component literal with the smallest variable (or
+ *   the largest, see below)
+ * --bounded variable elimination: a variable v is eliminated by replacing the
+ *   clauses mentioning it with all their non-tautological resolvents on v, when
+ *   there are no more resolvents than clauses
+ *
+ * The preprocessor works on its own copy of the clauses, with an occurrence list
+ * per literal and a 64-bit signature per clause (one bit per literal hash), so
+ * that most subset checks are ruled out by a single AND.
+ *
+ * Eliminated variables do not appear in the simplified cnf. The clauses removed
+ * with each of them are kept on an elimination stack, and a model of the
+ * simplified cnf is extended to the eliminated variables by going over the stack
+ * backwards, setting each variable so that its removed clauses are satisfied.
+ *
+ * Variable elimination preserves satisfiability but not the models, so it is
+ * for sat solving only. sat_simplify() skips it for compiling and counting: the
+ * other steps yield an equivalent cnf, except that a substituted variable no
+ * longer appears in it unless its equivalence is kept, which doubles the count.
+ *
+ * The representative of a component takes over the clauses of the others, so it
+ * joins their neighbourhoods in the primal graph. A vtree built from an elimination
+ * order is narrowest when that variable is eliminated last: substituting by the
+ * smallest variable under the natural order (1,2,...,n) widened the vtree of
+ * s713.scan from 34 to 52. sat_simplify() therefore lets the caller pick the
+ * largest variable instead.
+ ******************************************************************************/
+
+#define ELIM_MAX_PRODUCT   400 //variables with more pairs of clauses to resolve are kept
+#define ELIM_MAX_RESOLVENT 20  //longest resolvent allowed when eliminating a variable
+#define SUBST_MAX_ROUNDS   8   //rounds of equivalent literal substitution
+
+struct elim_stack {
+    c2dLiteral* data;   //records: variable, number of clauses, then each clause
+    c2dSize size;       //as its size followed by its literals
+    c2dSize buf_len;
+    c2dSize* records;   //start of each record in data
+    c2dSize n_records;
+    c2dSize records_buf_len;
+    c2dSize n_eliminated; //records of eliminated variables (the others are substitutions)
+};
+
+typedef struct {
+    c2dLiteral* lits;
+    c2dSize size;
+    unsigned long sig;
+    BOOLEAN removed;
+    BOOLEAN queued;     //waiting in the subsumption queue
+} PClause;
+
+typedef struct {
+    c2dSize* ids;
+    c2dSize n;
+    c2dSize buf_len;
+} OccList;
+
+typedef struct {
+    c2dSize n;
+    PClause* clauses;
+    c2dSize n_clauses;
+    c2dSize clauses_buf_len;
+    OccList* occ;       //occ[l + n] lists the clauses containing literal l
+    signed char* value; //value[v] is 1 (true), -1 (false) or 0 (unassigned)
+    BOOLEAN* eliminated;
+    signed char* mark;  //scratch: sign of the literal of each variable in a clause
+    c2dLiteral* repr;   //scratch: repr[v] is the literal replacing variable v (or v)
+    c2dLiteral* units;  //literals waiting to be propagated
+    c2dSize n_units;
+    c2dSize units_buf_len;
+    c2dSize* queue;     //clauses waiting to be checked for subsumption
+    c2dSize queue_head;
+    c2dSize queue_tail;
+    c2dSize queue_buf_len;
+    BOOLEAN unsat;
+    ElimStack* stack;
+    Proof* proof;       //where added and removed clauses are logged (or NULL)
+} Preprocessor;
+
+/******************************************************************************
+ * Clauses and occurrence lists
+ ******************************************************************************/
+
+static c2dSize var_of(c2dLiteral lit) {
+    return lit > 0 ? (c2dSize)lit : (c2dSize)-lit;
+}
+
+static signed char sign_of(c2dLiteral lit) {
+    return lit > 0 ? 1 : -1;
+}
+
+static unsigned long lit_sig(c2dLiteral lit) {
+    c2dSize code = lit > 0 ? 2 * (c2dSize)lit : 2 * (c2dSize)-lit + 1;
+    return 1UL << (code % 64);
+}
+
+static OccList* occ_of(Preprocessor* pp, c2dLiteral lit) {
+    return &pp->occ[lit + (c2dLiteral)pp->n];
+}
+
+static void occ_add(OccList* list, c2dSize id) {
+    if (list->n == list->buf_len) {
+        list->buf_len = list->buf_len ? 2 * list->buf_len : 4;
+        list->ids = realloc(list->ids, sizeof(c2dSize) * list->buf_len);
+    }
+    list->ids[list->n++] = id;
+}
+
+static void occ_remove(OccList* list, c2dSize id) {
+    for(c2dSize i = 0; i < list->n; ++i)
+        if (list->ids[i] == id) {
+            list->ids[i] = list->ids[--list->n];
+            return;
+        }
+}
+
+//drops removed clauses from an occurrence list, returns its length
+static c2dSize occ_clean(Preprocessor* pp, OccList* list) {
+    c2dSize kept = 0;
+    for(c2dSize i = 0; i < list->n; ++i)
+        if (!pp->clauses[list->ids[i]].removed) list->ids[kept++] = list->ids[i];
+    list->n = kept;
+    return kept;
+}
+
+static void enqueue(Preprocessor* pp, c2dSize id) {
+    if (pp->clauses[id].queued) return;
+    if (pp->queue_tail == pp->queue_buf_len) {
+        //compact, then grow if needed
+        memmove(pp->queue, pp->queue + pp->queue_head,
+                sizeof(c2dSize) * (pp->queue_tail - pp->queue_head));
+        pp->queue_tail -= pp->queue_head;
+        pp->queue_head = 0;
+        if (pp->queue_tail == pp->queue_buf_len) {
+            pp->queue_buf_len = pp->queue_buf_len ? 2 * pp->queue_buf_len : 64;
+            pp->queue = realloc(pp->queue, sizeof(c2dSize) * pp->queue_buf_len);
+        }
+    }
+    pp->queue[pp->queue_tail++] = id;
+    pp->clauses[id].queued = 1;
+}
+
+static void compute_sig(PClause* clause) {
+    clause->sig = 0;
+    for(c2dSize j = 0; j < clause->size; ++j) clause->sig |= lit_sig(clause->lits[j]);
+}
+
+static void add_unit(Preprocessor* pp, c2dLiteral lit) {
+    proof_step(pp->proof, 'a', &lit, 1);
+    if (pp->n_units == pp->units_buf_len) {
+        pp->units_buf_len = pp->units_buf_len ? 2 * pp->units_buf_len : 64;
+        pp->units = realloc(pp->units, sizeof(c2dLiteral) * pp->units_buf_len);
+    }
+    pp->units[pp->n_units++] = lit;
+}
+
+//adds a clause (whose literals are distinct and not complementary), taking its literals
+static void add_clause(Preprocessor* pp, c2dLiteral* lits, c2dSize size) {
+    if (size == 0) {
+        free(lits);
+        pp->unsat = 1;
+        return;
+    }
+    if (size == 1) {
+        add_unit(pp, lits[0]);
+        free(lits);
+        return;
+    }
+    if (pp->n_clauses == pp->clauses_buf_len) {
+        pp->clauses_buf_len = pp->clauses_buf_len ? 2 * pp->clauses_buf_len : 64;
+        pp->clauses = realloc(pp->clauses, sizeof(PClause) * pp->clauses_buf_len);
+    }
+    proof_step(pp->proof, 'a', lits, size);
+    c2dSize id = pp->n_clauses++;
+    PClause* clause = &pp->clauses[id];
+    clause->lits = lits;
+    clause->size = size;
+    clause->removed = 0;
+    clause->queued = 0;
+    compute_sig(clause);
+    for(c2dSize j = 0; j < size; ++j) occ_add(occ_of(pp, lits[j]), id);
+    enqueue(pp, id);
+}
+
+static void remove_clause(Preprocessor* pp, c2dSize id) {
+    PClause* clause = &pp->clauses[id];
+    proof_step(pp->proof, 'd', clause->lits, clause->size);
+    clause->removed = 1;
+    free(clause->lits);
+    clause->lits = NULL;
+}
+
+//removes lit from a clause (self-subsuming strengthening or a false literal)
+static void strengthen(Preprocessor* pp, c2dSize id, c2dLiteral lit) {
+    PClause* clause = &pp->clauses[id];
+    c2dSize kept = 0;
+    for(c2dSize j = 0; j < clause->size; ++j)
+        if (clause->lits[j] != lit) clause->lits[kept++] = clause->lits[j];
+    if (pp->proof) { //the shorter clause is added before the longer one is deleted
+        proof_step(pp->proof, 'a', clause->lits, kept);
+        clause->lits[kept] = lit;
+        proof_step(pp->proof, 'd', clause->lits, kept + 1);
+    }
+    clause->size = kept;
+    occ_remove(occ_of(pp, lit), id);
+    if (kept == 1) {
+        add_unit(pp, clause->lits[0]);
+        occ_remove(occ_of(pp, clause->lits[0]), id);
+        remove_clause(pp, id);
+        return;
+    }
+    compute_sig(clause);
+    enqueue(pp, id); //it may subsume more clauses now
+}
+
+/******************************************************************************
+ * Unit propagation
+ ******************************************************************************/
+
+static void propagate(Preprocessor* pp) {
+    while (pp->n_units > 0 && !pp->unsat) {
+        c2dLiteral lit = pp->units[--pp->n_units];
+        c2dSize v = var_of(lit);
+        if (pp->value[v] == sign_of(lit)) continue;
+        if (pp->value[v] != 0) {
+            pp->unsat = 1;
+            return;
+        }
+        pp->value[v] = sign_of(lit);
+        OccList* sat_list = occ_of(pp, lit);
+        for(c2dSize i = 0; i < sat_list->n; ++i)
+            if (!pp->clauses[sat_list->ids[i]].removed) remove_clause(pp, sat_list->ids[i]);
+        sat_list->n = 0;
+        OccList* false_list = occ_of(pp, -lit);
+        while (occ_clean(pp, false_list) > 0) strengthen(pp, false_list->ids[0], -lit);
+    }
+}
+
+/******************************************************************************
+ * Subsumption and strengthening
+ ******************************************************************************/
+
+//removes the clauses subsumed by clause id, and strengthens the ones it
+//self-subsumes
+static void backward_subsume(Preprocessor* pp, c2dSize id) {
+    PClause* clause = &pp->clauses[id];
+    //the literal of the clause whose variable occurs least
+    c2dLiteral best = clause->lits[0];
+    c2dSize best_n = occ_of(pp, best)->n + occ_of(pp, -best)->n;
+    for(c2dSize j = 1; j < clause->size; ++j) {
+        c2dLiteral lit = clause->lits[j];
+        c2dSize n = occ_of(pp, lit)->n + occ_of(pp, -lit)->n;
+        if (n < best_n) {
+            best = lit;
+            best_n = n;
+        }
+    }
+    for(c2dSize j = 0; j < clause->size; ++j) pp->mark[var_of(clause->lits[j])] = sign_of(clause->lits[j]);
+
+    for(int polarity = 0; polarity < 2; ++polarity) {
+        //strengthening changes occurrence lists, so a copy of the list is scanned
+        OccList* list = occ_of(pp, polarity ? -best : best);
+        c2dSize n_ids = occ_clean(pp, list);
+        c2dSize* ids = malloc(sizeof(c2dSize) * (n_ids + 1));
+        memcpy(ids, list->ids, sizeof(c2dSize) * n_ids);
+        for(c2dSize i = 0; i < n_ids; ++i) {
+            PClause* other = &pp->clauses[ids[i]];
+            if (ids[i] == id || other->removed || other->size < clause->size ||
+                (clause->sig & ~other->sig) != 0) continue;
+            c2dSize same = 0;
+            c2dLiteral flipped = 0;
+            for(c2dSize j = 0; j < other->size; ++j) {
+                signed char m = pp->mark[var_of(other->lits[j])];
+                if (m == sign_of(other->lits[j])) ++same;
+                else if (m != 0) flipped = other->lits[j];
+            }
+            if (same == clause->size) remove_clause(pp, ids[i]);
+            else if (same == clause->size - 1 && flipped != 0) strengthen(pp, ids[i], flipped);
+        }
+        free(ids);
+    }
+    for(c2dSize j = 0; j < clause->size; ++j) pp->mark[var_of(clause->lits[j])] = 0;
+}
+
+static void subsume_queued(Preprocessor* pp) {
+    while (!pp->unsat) {
+        propagate(pp);
+        if (pp->queue_head == pp->queue_tail) break;
+        c2dSize id = pp->queue[pp->queue_head++];
+        pp->clauses[id].queued = 0;
+        if (!pp->clauses[id].removed) backward_subsume(pp, id);
+    }
+}
+
+/******************************************************************************
+ * Equivalent literal substitution
+ ******************************************************************************/
+
+//node of a literal in the implication graph
+static c2dSize node_of(const Preprocessor* pp, c2dLiteral lit) {
+    return (c2dSize)(lit + (c2dLiteral)pp->n);
+}
+
+static c2dLiteral lit_of(const Preprocessor* pp, c2dSize node) {
+    return (c2dLiteral)node - (c2dLiteral)pp->n;
+}
+
+//finds the strongly connected components of the implication graph of the binary
+//clauses (Tarjan, without recursion) and sets repr[v] for every variable, to the
+//literal of its component with the largest variable if largest is 1, the smallest
+//otherwise
+//returns the number of variables whose representative is another literal
+static c2dSize find_equivalences(Preprocessor* pp, BOOLEAN largest) {
+    c2dSize n_nodes = 2 * pp->n + 1;
+    //edges -a -> b and -b -> a of each binary clause (a or b), in CSR form
+    c2dSize* start = calloc(n_nodes + 1, sizeof(c2dSize));
+    for(c2dSize id = 0; id < pp->n_clauses; ++id) {
+        PClause* clause = &pp->clauses[id];
+        if (clause->removed || clause->size != 2) continue;
+        if (pp->eliminated[var_of(clause->lits[0])] || pp->eliminated[var_of(clause->lits[1])]) continue;
+        ++start[node_of(pp, -clause->lits[0]) + 1];
+        ++start[node_of(pp, -clause->lits[1]) + 1];
+    }
+    for(c2dSize i = 0; i < n_nodes; ++i) start[i + 1] += start[i];
+    c2dSize* edges = malloc(sizeof(c2dSize) * (start[n_nodes] + 1));
+    c2dSize* fill = malloc(sizeof(c2dSize) * n_nodes);
+    memcpy(fill, start, sizeof(c2dSize) * n_nodes);
+    for(c2dSize id = 0; id < pp->n_clauses; ++id) {
+        PClause* clause = &pp->clauses[id];
+        if (clause->removed || clause->size != 2) continue;
+        if (pp->eliminated[var_of(clause->lits[0])] || pp->eliminated[var_of(clause->lits[1])]) continue;
+        edges[fill[node_of(pp, -clause->lits[0])]++] = node_of(pp, clause->lits[1]);
+        edges[fill[node_of(pp, -clause->lits[1])]++] = node_of(pp, clause->lits[0]);
+    }
+
+    c2dSize* index = calloc(n_nodes, sizeof(c2dSize)); //0: not visited yet
+    c2dSize* low = malloc(sizeof(c2dSize) * n_nodes);
+    c2dSize* next_edge = fill; //reused: next edge of each node to follow
+    c2dSize* call = malloc(sizeof(c2dSize) * n_nodes);
+    c2dSize* scc = malloc(sizeof(c2dSize) * n_nodes);
+    BOOLEAN* on_scc = calloc(n_nodes, sizeof(BOOLEAN));
+    c2dSize n_index = 0;
+    c2dSize n_scc = 0;
+    for(c2dSize v = 1; v <= pp->n; ++v) pp->repr[v] = (c2dLiteral)v;
+
+    for(c2dSize root = 0; root < n_nodes; ++root) {
+        if (index[root] != 0 || start[root] == start[root + 1]) continue;
+        c2dSize depth = 0;
+        call[depth++] = root;
+        index[root] = low[root] = ++n_index;
+        next_edge[root] = start[root];
+        scc[n_scc++] = root;
+        on_scc[root] = 1;
+        while (depth > 0) {
+            c2dSize node = call[depth - 1];
+            if (next_edge[node] < start[node + 1]) {
+                c2dSize succ = edges[next_edge[node]++];
+                if (index[succ] == 0) {
+                    index[succ] = low[succ] = ++n_index;
+                    next_edge[succ] = start[succ];
+                    scc[n_scc++] = succ;
+                    on_scc[succ] = 1;
+                    call[depth++] = succ;
+                } else if (on_scc[succ] && index[succ] < low[node]) {
+                    low[node] = index[succ];
+                }
+                continue;
+            }
+            --depth;
+            if (depth > 0 && low[node] < low[call[depth - 1]]) low[call[depth - 1]] = low[node];
+            if (low[node] != index[node]) continue;
+            //node is the root of a component: its literal with the smallest (or
+            //largest) variable represents it
+            c2dSize first = n_scc;
+            do --first; while (scc[first] != node);
+            c2dLiteral best = lit_of(pp, node);
+            for(c2dSize i = first; i < n_scc; ++i) {
+                c2dLiteral lit = lit_of(pp, scc[i]);
+                if (largest ? var_of(lit) > var_of(best) : var_of(lit) < var_of(best)) best = lit;
+            }
+            for(c2dSize i = first; i < n_scc; ++i) {
+                c2dLiteral lit = lit_of(pp, scc[i]);
+                on_scc[scc[i]] = 0;
+                if (lit == -best) { //a literal is equivalent to its negation
+                    c2dLiteral units[2] = { -best, best };
+                    proof_step(pp->proof, 'a', units, 1);
+                    proof_step(pp->proof, 'a', units + 1, 1);
+                    pp->unsat = 1;
+                }
+                else if (lit != best) pp->repr[var_of(lit)] = lit > 0 ? best : -best;
+            }
+            n_scc = first;
+        }
+    }
+
+    c2dSize substituted = 0;
+    for(c2dSize v = 1; v <= pp->n; ++v) substituted += pp->repr[v] != (c2dLiteral)v;
+    free(start);
+    free(edges);
+    free(fill);
+    free(index);
+    free(low);
+    free(call);
+    free(scc);
+    free(on_scc);
+    return substituted;
+}
+
+static void stack_push(ElimStack* stack, c2dLiteral x);
+static void stack_record(ElimStack* stack);
+
+//replaces each variable v with repr[v] in all clauses, and then either keeps the
+//equivalence of v as two binary clauses or records it on the elimination stack
+//(so that v can be set from its representative when a model is extended)
+static void substitute(Preprocessor* pp, BOOLEAN keep_equivalences) {
+    //the equivalences make the rewritten clauses checkable, while the binary
+    //clauses they come from are still there
+    for(c2dSize v = 1; v <= pp->n && pp->proof; ++v) {
+        c2dLiteral r = pp->repr[v];
+        if (r == (c2dLiteral)v) continue;
+        c2dLiteral lits[4] = { (c2dLiteral)v, -r, -(c2dLiteral)v, r };
+        proof_step(pp->proof, 'a', lits, 2);
+        proof_step(pp->proof, 'a', lits + 2, 2);
+    }
+    for(c2dSize id = 0; id < pp->n_clauses && !pp->unsat; ++id) {
+        PClause* clause = &pp->clauses[id];
+        if (clause->removed) continue;
+        BOOLEAN changed = 0;
+        for(c2dSize j = 0; j < clause->size; ++j)
+            changed |= pp->repr[var_of(clause->lits[j])] != (c2dLiteral)var_of(clause->lits[j]);
+        if (!changed) continue;
+
+        c2dLiteral* lits = malloc(sizeof(c2dLiteral) * clause->size);
+        c2dSize size = 0;
+        BOOLEAN tautology = 0;
+        for(c2dSize j = 0; j < clause->size; ++j) {
+            c2dLiteral lit = clause->lits[j];
+            lit = lit > 0 ? pp->repr[lit] : -pp->repr[-lit];
+            signed char m = pp->mark[var_of(lit)];
+            if (m == -sign_of(lit)) tautology = 1;
+            else if (m == 0) {
+                pp->mark[var_of(lit)] = sign_of(lit);
+                lits[size++] = lit;
+            }
+        }
+        for(c2dSize j = 0; j < size; ++j) pp->mark[var_of(lits[j])] = 0;
+        for(c2dSize j = 0; j < clause->size; ++j) occ_remove(occ_of(pp, clause->lits[j]), id);
+        if (tautology) free(lits);
+        else add_clause(pp, lits, size); //clauses may move: id is used from now on
+        remove_clause(pp, id);
+    }
+
+    for(c2dSize v = 1; v <= pp->n && !pp->unsat; ++v) {
+        c2dLiteral r = pp->repr[v];
+        if (r == (c2dLiteral)v) continue;
+        pp->eliminated[v] = 1;
+        if (keep_equivalences) {
+            c2dLiteral* lits = malloc(sizeof(c2dLiteral) * 2);
+            lits[0] = (c2dLiteral)v;
+            lits[1] = -r;
+            add_clause(pp, lits, 2);
+            lits = malloc(sizeof(c2dLiteral) * 2);
+            lits[0] = -(c2dLiteral)v;
+            lits[1] = r;
+            add_clause(pp, lits, 2);
+        } else if (pp->stack) {
+            stack_record(pp->stack);
+            stack_push(pp->stack, (c2dLiteral)v);
+            stack_push(pp->stack, 2);
+            stack_push(pp->stack, 2);
+            stack_push(pp->stack, (c2dLiteral)v);
+            stack_push(pp->stack, -r);
+            stack_push(pp->stack, 2);
+            stack_push(pp->stack, -(c2dLiteral)v);
+            stack_push(pp->stack, r);
+        }
+    }
+}
+
+//substitutes equivalent literals until no more are found, by the literal with the
+//largest variable of each component if largest is 1, the smallest otherwise
+//returns the number of substituted variables
+static c2dSize substitute_rounds(Preprocessor* pp, BOOLEAN keep_equivalences, BOOLEAN largest) {
+    c2dSize total = 0;
+    for(int round = 0; round < SUBST_MAX_ROUNDS && !pp->unsat; ++round) {
+        c2dSize substituted = find_equivalences(pp, largest);
+        if (substituted == 0 || pp->unsat) break;
+        substitute(pp, keep_equivalences);
+        subsume_queued(pp);
+        total += substituted;
+    }
+    return total;
+}
+
+/******************************************************************************
+ * Bounded variable elimination
+ ******************************************************************************/
+
+static void stack_push(ElimStack* stack, c2dLiteral x) {
+    if (stack->size == stack->buf_len) {
+        stack->buf_len = stack->buf_len ? 2 * stack->buf_len : 256;
+        stack->data = realloc(stack->data, sizeof(c2dLiteral) * stack->buf_len);
+    }
+    stack->data[stack->size++] = x;
+}
+
+static void stack_record(ElimStack* stack) {
+    if (stack->n_records == stack->records_buf_len) {
+        stack->records_buf_len = stack->records_buf_len ? 2 * stack->records_buf_len : 64;
+        stack->records = realloc(stack->records, sizeof(c2dSize) * stack->records_buf_len);
+    }
+    stack->records[stack->n_records++] = stack->size;
+}
+
+//returns the size of the resolvent of clauses p and n on variable v, or -1 if
+//it is a tautology (the literals of p must be marked)
+static long resolvent_size(Preprocessor* pp, const PClause* p, const PClause* n, c2dSize v) {
+    long size = p->size - 1;
+    for(c2dSize j = 0; j < n->size; ++j) {
+        c2dLiteral lit = n->lits[j];
+        if (var_of(lit) == v) continue;
+        signed char m = pp->mark[var_of(lit)];
+        if (m == -sign_of(lit)) return -1;
+        if (m == 0) ++size;
+    }
+    return size;
+}
+
+static void mark_clause(Preprocessor* pp, const PClause* clause, BOOLEAN on) {
+    for(c2dSize j = 0; j < clause->size; ++j)
+        pp->mark[var_of(clause->lits[j])] = on ? sign_of(clause->lits[j]) : 0;
+}
+
+//eliminates variable v if this does not increase the number of clauses
+//returns 1 if v was eliminated
+static BOOLEAN try_eliminate(Preprocessor* pp, c2dSize v) {
+    OccList* pos = occ_of(pp, (c2dLiteral)v);
+    OccList* neg = occ_of(pp, -(c2dLiteral)v);
+    c2dSize n_pos = occ_clean(pp, pos);
+    c2dSize n_neg = occ_clean(pp, neg);
+    if (n_pos + n_neg == 0 || n_pos * n_neg > ELIM_MAX_PRODUCT) return 0;
+
+    //count the resolvents first
+    c2dSize n_resolvents = 0;
+    for(c2dSize i = 0; i < n_pos; ++i) {
+        PClause* p = &pp->clauses[pos->ids[i]];
+        mark_clause(pp, p, 1);
+        for(c2dSize k = 0; k < n_neg && n_resolvents <= n_pos + n_neg; ++k) {
+            long size = resolvent_size(pp, p, &pp->clauses[neg->ids[k]], v);
+            if (size < 0) continue;
+            if (size > ELIM_MAX_RESOLVENT) n_resolvents = n_pos + n_neg; //too long: give up
+            ++n_resolvents;
+        }
+        mark_clause(pp, p, 0);
+        if (n_resolvents > n_pos + n_neg) return 0;
+    }
+
+    //the clauses of v go to the elimination stack
+    stack_record(pp->stack);
+    ++pp->stack->n_eliminated;
+    stack_push(pp->stack, (c2dLiteral)v);
+    stack_push(pp->stack, (c2dLiteral)(n_pos + n_neg));
+    for(int polarity = 0; polarity < 2; ++polarity) {
+        OccList* list = polarity ? neg : pos;
+        for(c2dSize i = 0; i < list->n; ++i) {
+            PClause* clause = &pp->clauses[list->ids[i]];
+            stack_push(pp->stack, (c2dLiteral)clause->size);
+            for(c2dSize j = 0; j < clause->size; ++j) stack_push(pp->stack, clause->lits[j]);
+        }
+    }
+
+    //add the resolvents (clauses may move when they are added, so ids are used)
+    c2dSize* pos_ids = malloc(sizeof(c2dSize) * (n_pos + 1));
+    c2dSize* neg_ids = malloc(sizeof(c2dSize) * (n_neg + 1));
+    memcpy(pos_ids, pos->ids, sizeof(c2dSize) * n_pos);
+    memcpy(neg_ids, neg->ids, sizeof(c2dSize) * n_neg);
+    for(c2dSize i = 0; i < n_pos; ++i) {
+        for(c2dSize k = 0; k < n_neg; ++k) {
+            PClause* p = &pp->clauses[pos_ids[i]];
+            PClause* n = &pp->clauses[neg_ids[k]];
+            mark_clause(pp, p, 1);
+            long size = resolvent_size(pp, p, n, v);
+            if (size >= 0) {
+                c2dLiteral* lits = malloc(sizeof(c2dLiteral) * (size + 1));
+                c2dSize s = 0;
+                for(c2dSize j = 0; j < p->size; ++j)
+                    if (var_of(p->lits[j]) != v) lits[s++] = p->lits[j];
+                for(c2dSize j = 0; j < n->size; ++j)
+                    if (var_of(n->lits[j]) != v && pp->mark[var_of(n->lits[j])] == 0)
+                        lits[s++] = n->lits[j];
+                mark_clause(pp, p, 0);
+                add_clause(pp, lits, s);
+            } else {
+                mark_clause(pp, p, 0);
+            }
+        }
+    }
+    for(c2dSize i = 0; i < n_pos; ++i) remove_clause(pp, pos_ids[i]);
+    for(c2dSize k = 0; k < n_neg; ++k) remove_clause(pp, neg_ids[k]);
+    pos->n = 0;
+    neg->n = 0;
+    free(pos_ids);
+    free(neg_ids);
+    pp->eliminated[v] = 1;
+    return 1;
+}
+
+static int compare_costs(const void* a, const void* b) {
+    const c2dSize* x = a;
+    const c2dSize* y = b;
+    return x[0] < y[0] ? -1 : (x[0] > y[0] ? 1 : (x[1] < y[1] ? -1 : x[1] > y[1]));
+}
+
+//one round of elimination over all variables, cheapest first
+//returns the number of eliminated variables
+static c2dSize eliminate_round(Preprocessor* pp) {
+    c2dSize* costs = malloc(sizeof(c2dSize) * 2 * (pp->n + 1));
+    c2dSize n_costs = 0;
+    for(c2dSize v = 1; v <= pp->n; ++v) {
+        if (pp->value[v] != 0 || pp->eliminated[v]) continue;
+        costs[2 * n_costs] = occ_clean(pp, occ_of(pp, (c2dLiteral)v)) *
+                             occ_clean(pp, occ_of(pp, -(c2dLiteral)v));
+        costs[2 * n_costs + 1] = v;
+        ++n_costs;
+    }
+    qsort(costs, n_costs, 2 * sizeof(c2dSize), compare_costs);
+    c2dSize eliminated = 0;
+    for(c2dSize i = 0; i < n_costs && !pp->unsat; ++i) {
+        c2dSize v = costs[2 * i + 1];
+        if (pp->value[v] != 0) continue;
+        if (try_eliminate(pp, v)) {
+            ++eliminated;
+            subsume_queued(pp);
+        }
+    }
+    free(costs);
+    return eliminated;
+}
+
+/******************************************************************************
+ * Loading and storing the cnf of a sat state
+ ******************************************************************************/
+
+static int compare_lits(const void* a, const void* b) {
+    c2dLiteral x = *(const c2dLiteral*)a;
+    c2dLiteral y = *(const c2dLiteral*)b;
+    return x < y ? -1 : (x > y);
+}
+
+static void load(Preprocessor* pp, SatState* sat_state) {
+    for(c2dSize i = 0; i < sat_state->m && !pp->unsat; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        c2dLiteral* lits = malloc(sizeof(c2dLiteral) * clause->n_literals);
+        for(c2dSize j = 0; j < clause->n_literals; ++j) lits[j] = clause->literals[j]->index;
+        qsort(lits, clause->n_literals, sizeof(c2dLiteral), compare_lits);
+        //drop duplicate literals and tautologies
+        c2dSize size = 0;
+        BOOLEAN tautology = 0;
+        for(c2dSize j = 0; j < clause->n_literals; ++j) {
+            if (size > 0 && lits[size - 1] == lits[j]) continue;
+            if (pp->mark[var_of(lits[j])] != 0) tautology = 1;
+            pp->mark[var_of(lits[j])] = sign_of(lits[j]);
+            lits[size++] = lits[j];
+        }
+        for(c2dSize j = 0; j < size; ++j) pp->mark[var_of(lits[j])] = 0;
+        if (tautology) free(lits);
+        else add_clause(pp, lits, size);
+    }
+}
+
+//replaces the cnf of sat state with the simplified clauses (and the units found)
+static void store(Preprocessor* pp, SatState* sat_state) {
+    formula_capture(sat_state);
+    for(c2dSize i = 0; i < sat_state->n; ++i) {
+        sat_state->variables[i]->n_clauses = 0;
+        sat_state->pos_literals[i]->n_clauses = 0;
+        sat_state->neg_literals[i]->n_clauses = 0;
+    }
+    trail_forget(sat_state);
+    for(c2dSize i = 0; i < sat_state->m; ++i) Clause_delete(sat_state->CNF_clauses[i]);
+    xor_matrix_free(sat_state->xor_matrix);
+    card_set_free(sat_state->card_set);
+
+    c2dSize m = 0;
+    for(c2dSize v = 1; v <= pp->n; ++v) m += pp->value[v] != 0;
+    for(c2dSize id = 0; id < pp->n_clauses; ++id) m += !pp->clauses[id].removed;
+    sat_state->m = m;
+    sat_state->CNF_clauses = realloc(sat_state->CNF_clauses, sizeof(Clause*) * (m + 1));
+    c2dSize i = 0;
+    for(c2dSize v = 1; v <= pp->n; ++v) {
+        if (pp->value[v] == 0) continue;
+        Lit** literals = malloc(sizeof(Lit*));
+        literals[0] = sat_index2literal(pp->value[v] * (c2dLiteral)v, sat_state);
+        ++i;
+        sat_state->CNF_clauses[i - 1] = Clause_new(i, literals, 1, m);
+    }
+    for(c2dSize id = 0; id < pp->n_clauses; ++id) {
+        PClause* clause = &pp->clauses[id];
+        if (clause->removed) continue;
+        Lit** literals = malloc(sizeof(Lit*) * clause->size);
+        for(c2dSize j = 0; j < clause->size; ++j)
+            literals[j] = sat_index2literal(clause->lits[j], sat_state);
+        ++i;
+        sat_state->CNF_clauses[i - 1] = Clause_new(i, literals, clause->size, m);
+    }
+    sat_state->xor_matrix = xor_matrix_new(sat_state);
+    sat_state->card_set = card_set_new(sat_state);
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+static void pp_init(Preprocessor* pp, SatState* sat_state) {
+    assert(sat_state->current_level == 1 && sat_state->n_learned_clauses == 0);
+    c2dSize n = sat_state->n;
+    memset(pp, 0, sizeof(Preprocessor));
+    pp->n          = n;
+    pp->occ        = calloc(2 * n + 1, sizeof(OccList));
+    pp->value      = calloc(n + 1, sizeof(signed char));
+    pp->eliminated = calloc(n + 1, sizeof(BOOLEAN));
+    pp->mark       = calloc(n + 1, sizeof(signed char));
+    pp->repr       = malloc(sizeof(c2dLiteral) * (n + 1));
+    load(pp, sat_state);
+    pp->proof      = sat_state->proof; //the cnf itself is not logged
+}
+
+static void pp_free(Preprocessor* pp) {
+    for(c2dSize id = 0; id < pp->n_clauses; ++id) free(pp->clauses[id].lits);
+    free(pp->clauses);
+    for(c2dSize id = 0; id <= 2 * pp->n; ++id) free(pp->occ[id].ids);
+    free(pp->occ);
+    free(pp->value);
+    free(pp->eliminated);
+    free(pp->mark);
+    free(pp->repr);
+    free(pp->units);
+    free(pp->queue);
+}
+
+//simplifies the cnf of sat state
+//returns 0 if the cnf is found to be unsatisfiable (the sat state is then unchanged), 1 otherwise
+BOOLEAN sat_preprocess(SatState* sat_state) {
+    if (sat_state->elim_stack == NULL) sat_state->elim_stack = calloc(1, sizeof(ElimStack));
+    ElimStack* stack = sat_state->elim_stack;
+    c2dSize stack_records = stack->n_records;
+    c2dSize stack_size = stack->size;
+    c2dSize stack_eliminated = stack->n_eliminated;
+    Preprocessor pp;
+    pp_init(&pp, sat_state);
+    pp.stack = stack;
+
+    subsume_queued(&pp);
+    substitute_rounds(&pp, 0, 0);
+    while (!pp.unsat && eliminate_round(&pp) > 0);
+
+    BOOLEAN ret = !pp.unsat;
+    if (ret) store(&pp, sat_state);
+    else { //nothing was eliminated after all
+        stack->n_records = stack_records;
+        stack->size = stack_size;
+        stack->n_eliminated = stack_eliminated;
+    }
+    pp_free(&pp);
+    return ret;
+}
+
+//simplifies the cnf of sat state without changing its models
+//returns 0 if the cnf is found to be unsatisfiable (the sat state is then unchanged), 1 otherwise
+BOOLEAN sat_simplify(BOOLEAN keep_equivalences, BOOLEAN largest_repr, SatState* sat_state) {
+    Preprocessor pp;
+    pp_init(&pp, sat_state);
+
+    subsume_queued(&pp);
+    c2dSize substituted = substitute_rounds(&pp, keep_equivalences, largest_repr);
+
+    BOOLEAN ret = !pp.unsat;
+    if (ret) {
+        store(&pp, sat_state);
+        if (!keep_equivalences) sat_state->n_substituted += substituted;
+    }
+    pp_free(&pp);
+    return ret;
+}
+
+//extends the last model found (see sat_model_literal()) to the eliminated variables
+void sat_extend_model(SatState* sat_state) {
+    ElimStack* stack = sat_state->elim_stack;
+    if (stack == NULL) return;
+    BOOLEAN* model = sat_state->model;
+    for(c2dSize r = stack->n_records; r > 0; --r) {
+        c2dLiteral* data = stack->data + stack->records[r - 1];
+        c2dSize v = (c2dSize)data[0];
+        c2dSize n_clauses = (c2dSize)data[1];
+        data += 2;
+        model[v] = 0;
+        for(c2dSize c = 0; c < n_clauses; ++c) {
+            c2dSize size = (c2dSize)data[0];
+            c2dLiteral* lits = data + 1;
+            data += size + 1;
+            BOOLEAN satisfied = 0;
+            c2dLiteral own = 0;
+            for(c2dSize j = 0; j < size; ++j) {
+                if (var_of(lits[j]) == v) own = lits[j];
+                else if (model[var_of(lits[j])] == (lits[j] > 0)) satisfied = 1;
+            }
+            if (!satisfied) model[v] = own > 0;
+        }
+    }
+}
+
+//returns the number of variables eliminated by sat_preprocess(), not counting
+//those it substituted
+c2dSize sat_eliminated_var_count(const SatState* sat_state) {
+    return sat_state->elim_stack ? sat_state->elim_stack->n_eliminated : 0;
+}
+
+//returns the number of variables dropped from the cnf by sat_simplify()
+c2dSize sat_substituted_var_count(const SatState* sat_state) {
+    return sat_state->n_substituted;
+}
+
+//returns a copy of the stack (for a clone of its sat state)
+ElimStack* elim_stack_clone(const ElimStack* stack) {
+    if (stack == NULL) return NULL;
+    ElimStack* copy = malloc(sizeof(ElimStack));
+    *copy = *stack;
+    copy->data = malloc(sizeof(c2dLiteral) * stack->buf_len);
+    copy->records = malloc(sizeof(c2dSize) * stack->records_buf_len);
+    memcpy(copy->data, stack->data, sizeof(c2dLiteral) * stack->size);
+    memcpy(copy->records, stack->records, sizeof(c2dSize) * stack->n_records);
+    return copy;
+}
+
+void elim_stack_free(ElimStack* stack) {
+    if (stack) {
+        free(stack->data);
+        free(stack->records);
+        free(stack);
+    }
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
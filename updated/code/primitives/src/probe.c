@@ -0,0 +1,382 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Probing at decision level 1
+ *
+ * Each candidate variable is decided both ways, one at a time, at level 2:
+ * --if deciding a literal leads to a contradiction, the clause learned from it
+ *   is asserted at level 1, which implies the complement of the literal
+ * --a literal implied by both decisions holds in every model, so it is learned
+ *   as a unit clause
+ *
+ * Candidates are the variables of binary clauses, as these are the ones whose
+ * decisions imply other literals right away.
+ *
+ * The literals implied by a decision form a tree: the parent of a literal is the
+ * deepest literal (of level 2) that every literal of level 2 implying it descends
+ * from, so that the parent alone implies it. A literal implied by a clause of more
+ * than two literals is thus implied by its parent through a chain of clauses, and
+ * the binary clause -parent or literal is learned (lazy hyper-binary resolution):
+ * later propagation finds it in one step. At most HBR_MAX_LEARNED(n) such clauses
+ * are learned, as each one slows down the propagation of its literals.
+ *
+ * After probing, a learned binary clause is removed when the other binary clauses
+ * imply it, that is, when the implication graph of the binary clauses has another
+ * path between its literals (transitive reduction). Binary clauses of the cnf are
+ * kept, as c2D relies on them. Both steps give up after HBR_MAX_WORK steps.
+ *
+ * Backbone extraction finds the literals that hold in all models: starting from
+ * a model, each literal of the model is checked by a query assuming its
+ * complement (see sat_solve_assuming()). An unsatisfiable query makes the literal
+ * a unit clause; a satisfiable one gives a model that rules out more candidates.
+ * A literal that a model can flip (each of its clauses has another true literal)
+ * is ruled out without a query.
+ * By default, a query gives up after learning BACKBONE_MAX_CONFLICTS clauses,
+ * leaving its literal out of the backbone found (see sat_set_backbone_conflicts()):
+ * each clause learned costs a pass over the clauses of the cnf, and most backbone
+ * literals fail within a conflict or two. The candidates given up are counted.
+ *
+ * The units found are kept as learned clauses, so they are implied at level 1
+ * whenever unit resolution runs, and the models of the cnf do not change.
+ ******************************************************************************/
+
+#define HBR_MAX_WORK 20000000 //literals and clauses visited by hyper-binary resolution
+                              //and by transitive reduction
+#define HBR_MAX_LEARNED(n) (n)       //binary clauses learned by hyper-binary resolution
+                                     //for a cnf of n variables
+
+//scratch for the implication trees of the decisions
+typedef struct {
+    Lit** parent;           //parent[l + n]: parent of literal l in the tree of the last decision
+    c2dSize* depth;         //depth[l + n]: its depth (the decision is at depth 0)
+    Lit** binaries;         //binary clauses found by the last decision, as pairs of literals
+    c2dSize n_binaries;
+    c2dSize binaries_buf_len;
+    c2dSize* visited;       //visited[l + n] == stamp if the search for a path reached l
+    c2dSize stamp;
+    Lit** stack;
+    unsigned long work;
+    c2dSize n_learned;      //binary clauses learned by hyper-binary resolution
+    c2dSize max_learned;    //after which it stops
+} Tree;
+
+//learns the unit clause lit and runs unit resolution at level 1
+//returns 0 if this leads to a contradiction, 1 otherwise
+static BOOLEAN learn_unit(Lit* lit, SatState* sat_state) {
+    Lit** literals = malloc(sizeof(Lit*));
+    literals[0] = lit;
+    Clause* clause = Clause_new(sat_clause_count(sat_state) +
+        sat_learned_clause_count(sat_state) + 1, literals, 1, sat_state->m);
+    return sat_assert_clause(clause, sat_state) == NULL;
+}
+
+//returns 1 if sat state has the binary clause a or b
+static BOOLEAN has_binary(const Lit* a, const Lit* b) {
+    const Lit* lit = a->n_clauses < b->n_clauses ? a : b;
+    const Lit* other = lit == a ? b : a;
+    for(c2dSize i = 0; i < lit->n_clauses; ++i) {
+        const Clause* clause = lit->clauses[i];
+        if (clause->n_literals == 2 &&
+            (clause->literals[0] == other || clause->literals[1] == other)) return 1;
+    }
+    return 0;
+}
+
+//returns the deepest common ancestor of literals a and b in the tree
+static Lit* common_ancestor(Lit* a, Lit* b, Tree* tree, c2dSize n) {
+    while (a != b) {
+        ++tree->work;
+        c2dSize depth_a = tree->depth[a->index + n];
+        c2dSize depth_b = tree->depth[b->index + n];
+        if (depth_a >= depth_b) a = tree->parent[a->index + n];
+        if (depth_b >= depth_a) b = tree->parent[b->index + n];
+    }
+    return a;
+}
+
+//builds the tree of the literals implied by the decision lit (implied holds them,
+//latest first), keeping the binary clause -parent or l for each literal l implied
+//by a longer clause
+static void hyper_binary_resolve(Lit** implied, c2dSize count, Tree* tree, SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    c2dSize level = sat_state->current_level;
+    tree->n_binaries = 0;
+    tree->parent[implied[0]->index + n] = NULL;
+    tree->depth[implied[0]->index + n] = 0;
+    for(c2dSize i = count; i > 1 && tree->work < HBR_MAX_WORK; --i) {
+        Lit* lit = implied[i - 1];
+        Lit* parent = NULL;
+        c2dSize n_causes = 0;
+        for(c2dSize j = 0; j < lit->n_implied_by; ++j) {
+            Lit* cause = lit->implied_by[j];
+            if (cause->decision_level != level) continue; //false at level 1
+            parent = parent ? common_ancestor(parent, cause, tree, n) : cause;
+            ++n_causes;
+        }
+        if (parent == NULL) parent = implied[0];
+        tree->parent[lit->index + n] = parent;
+        tree->depth[lit->index + n] = tree->depth[parent->index + n] + 1;
+        //a clause with a single literal of level 2 propagates like a binary clause
+        //already, its other literals being false at level 1
+        if (n_causes < 2 || tree->n_learned + tree->n_binaries / 2 >= tree->max_learned) continue;
+        Lit* first = sat_literal_complement(parent);
+        tree->work += first->n_clauses < lit->n_clauses ? first->n_clauses : lit->n_clauses;
+        if (has_binary(first, lit)) continue;
+        if (tree->n_binaries + 2 > tree->binaries_buf_len) {
+            tree->binaries_buf_len = tree->binaries_buf_len ? 2 * tree->binaries_buf_len : 64;
+            tree->binaries = realloc(tree->binaries, sizeof(Lit*) * tree->binaries_buf_len);
+        }
+        tree->binaries[tree->n_binaries++] = first;
+        tree->binaries[tree->n_binaries++] = lit;
+    }
+}
+
+//learns the binary clauses found by the last decision (at level 1, where none of
+//their literals is set)
+static void learn_binaries(Tree* tree, SatState* sat_state) {
+    for(c2dSize i = 0; i < tree->n_binaries; i += 2) {
+        Lit** literals = malloc(sizeof(Lit*) * 2);
+        literals[0] = tree->binaries[i];
+        literals[1] = tree->binaries[i + 1];
+        if (sat_state->proof) { //implied by unit resolution from the clauses learned before
+            c2dLiteral lits[2] = { literals[0]->index, literals[1]->index };
+            proof_step(sat_state->proof, 'a', lits, 2);
+        }
+        append_learned(literals, 2, sat_state);
+        ++tree->n_learned;
+    }
+    sat_state->n_hyper_binaries += tree->n_binaries / 2;
+    tree->n_binaries = 0;
+}
+
+//decides lit at level 2 and returns the literals it implies (lit included), with
+//their number in *count, learning the binary clauses found by hyper-binary resolution
+//returns NULL if the decision fails, after asserting the clause learned from it
+//(*consistent then tells whether level 1 is still consistent)
+static Lit** probe_literal(Lit* lit, c2dSize* count, BOOLEAN* consistent, Tree* tree, SatState* sat_state) {
+    Clause* learned = sat_decide_literal(lit, sat_state);
+    Lit** implied = NULL;
+    if (learned == NULL) {
+        *count = 1;
+        for(LitNode* node = sat_state->implied_literals;
+            node != NULL && node->literal->decision_level == sat_state->current_level;
+            node = node->prev)
+            ++*count;
+        implied = malloc(sizeof(Lit*) * *count);
+        implied[0] = lit;
+        c2dSize i = 1;
+        for(LitNode* node = sat_state->implied_literals; i < *count; node = node->prev)
+            implied[i++] = node->literal;
+        hyper_binary_resolve(implied, *count, tree, sat_state);
+    }
+    sat_undo_decide_literal(sat_state);
+    if (learned != NULL) {
+        assert(sat_at_assertion_level(learned, sat_state));
+        *consistent = sat_assert_clause(learned, sat_state) == NULL;
+    }
+    else learn_binaries(tree, sat_state);
+    return implied;
+}
+
+static BOOLEAN in_binary_clause(const Var* var) {
+    for(c2dSize i = 0; i < var->n_clauses; ++i)
+        if (sat_clause_size(var->clauses[i]) == 2) return 1;
+    return 0;
+}
+
+//probes the candidate variables, learning the units found
+//returns 0 if the cnf is found to be unsatisfiable, 1 otherwise
+static BOOLEAN probe_vars(Tree* tree, SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    BOOLEAN* mark = calloc(2 * n + 1, sizeof(BOOLEAN));
+    BOOLEAN consistent = 1;
+    for(c2dSize i = 1; i <= n && consistent; ++i) {
+        Var* var = sat_index2var(i, sat_state);
+        if (sat_instantiated_var(var) || !in_binary_clause(var)) continue;
+        c2dSize n_pos, n_neg;
+        Lit** pos = probe_literal(sat_pos_literal(var), &n_pos, &consistent, tree, sat_state);
+        if (pos == NULL) continue;
+        Lit** neg = probe_literal(sat_neg_literal(var), &n_neg, &consistent, tree, sat_state);
+        if (neg != NULL) {
+            //the literals implied by both decisions are kept in neg
+            for(c2dSize j = 0; j < n_pos; ++j) mark[pos[j]->index + n] = 1;
+            c2dSize n_units = 0;
+            for(c2dSize j = 0; j < n_neg; ++j)
+                if (mark[neg[j]->index + n]) neg[n_units++] = neg[j];
+            for(c2dSize j = 0; j < n_pos; ++j) mark[pos[j]->index + n] = 0;
+            for(c2dSize j = 0; j < n_units && consistent; ++j) {
+                if (sat_implied_literal(neg[j])) continue;
+                if (sat_state->proof) { //the unit follows from x -> l and -x -> l
+                    c2dLiteral l = sat_literal_index(neg[j]);
+                    c2dLiteral lits[4] = { -(c2dLiteral)i, l, (c2dLiteral)i, l };
+                    proof_step(sat_state->proof, 'a', lits, 2);
+                    proof_step(sat_state->proof, 'a', lits + 2, 2);
+                }
+                consistent = learn_unit(neg[j], sat_state);
+            }
+            free(neg);
+        }
+        free(pos);
+    }
+    free(mark);
+    return consistent;
+}
+
+//returns 1 if the binary clauses of sat state but clause (and those removed) imply
+//clause, that is, if they have a path from the complement of its first literal to
+//its second literal
+static BOOLEAN implied_binary(const Clause* clause, const BOOLEAN* removed, Tree* tree,
+                              const SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    c2dSize m = sat_state->m;
+    Lit* target = clause->literals[1];
+    ++tree->stamp;
+    c2dSize top = 0;
+    tree->stack[top++] = sat_literal_complement(clause->literals[0]);
+    tree->visited[tree->stack[0]->index + n] = tree->stamp;
+    while (top > 0 && tree->work < HBR_MAX_WORK) {
+        //lit implies the other literal of each binary clause with its complement
+        Lit* lit = sat_literal_complement(tree->stack[--top]);
+        tree->work += lit->n_clauses;
+        for(c2dSize i = 0; i < lit->n_clauses; ++i) {
+            const Clause* other = lit->clauses[i];
+            if (other == clause || other->n_literals != 2) continue;
+            if (other->index > m && removed[other->index - m - 1]) continue;
+            Lit* next = other->literals[0] == lit ? other->literals[1] : other->literals[0];
+            if (next == target) return 1;
+            if (tree->visited[next->index + n] == tree->stamp) continue;
+            tree->visited[next->index + n] = tree->stamp;
+            tree->stack[top++] = next;
+        }
+    }
+    return 0;
+}
+
+//removes the learned binary clauses that other binary clauses imply
+static void reduce_binaries(Tree* tree, SatState* sat_state) {
+    c2dSize n_learned = sat_state->n_learned_clauses;
+    BOOLEAN* removed = calloc(n_learned + 1, sizeof(BOOLEAN));
+    Clause** reduced = malloc(sizeof(Clause*) * (n_learned + 1));
+    c2dSize n_reduced = 0;
+    for(c2dSize i = 0; i < n_learned && tree->work < HBR_MAX_WORK; ++i) {
+        Clause* clause = sat_state->learned_clauses[i];
+        if (clause->n_literals != 2 || !implied_binary(clause, removed, tree, sat_state)) continue;
+        removed[i] = 1;
+        reduced[n_reduced++] = clause;
+    }
+    if (n_reduced > 0) remove_learned(reduced, n_reduced, sat_state);
+    sat_state->n_reduced_binaries += n_reduced;
+    free(removed);
+    free(reduced);
+}
+
+//returns 1 if lit, true in the last model found, can be flipped in it: each cnf
+//clause of lit has another literal true in the model (learned clauses follow)
+static BOOLEAN flippable(const Lit* lit, const SatState* sat_state) {
+    for(c2dSize i = 0; i < lit->n_clauses; ++i) {
+        const Clause* clause = lit->clauses[i];
+        if (clause->index > sat_state->m) continue;
+        BOOLEAN satisfied = 0;
+        for(c2dSize j = 0; j < clause->n_literals && !satisfied; ++j)
+            satisfied = clause->literals[j] != lit && sat_model_literal(clause->literals[j], sat_state);
+        if (!satisfied) return 0;
+    }
+    return 1;
+}
+
+//rules out the candidates from variable i on that the last model found shows are
+//not backbone literals: those it sets otherwise, and those it could flip
+static void rule_out(c2dSize i, const BOOLEAN* candidate, BOOLEAN* known, const SatState* sat_state) {
+    for(c2dSize j = i; j <= sat_state->n; ++j) {
+        if (known[j]) continue;
+        Var* var = sat_index2var(j, sat_state);
+        Lit* lit = candidate[j] ? sat_pos_literal(var) : sat_neg_literal(var);
+        if (sat_state->model[j] != candidate[j] || flippable(lit, sat_state)) known[j] = 1;
+    }
+}
+
+//learns the backbone literals of the cnf, but those whose query gives up (which
+//are counted)
+//returns 0 if the cnf is unsatisfiable, 1 otherwise
+static BOOLEAN find_backbone(SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    if (!sat_solve_assuming(NULL, 0, sat_state)) return 0;
+    //candidate[i] is the value variable i has in every model found so far
+    BOOLEAN* candidate = malloc(sizeof(BOOLEAN) * (n + 1));
+    BOOLEAN* known = calloc(n + 1, sizeof(BOOLEAN)); //not a backbone variable, or learned
+    memcpy(candidate, sat_state->model, sizeof(BOOLEAN) * (n + 1));
+    rule_out(1, candidate, known, sat_state);
+
+    for(c2dSize i = 1; i <= n; ++i) {
+        if (known[i]) continue;
+        Var* var = sat_index2var(i, sat_state);
+        Lit* lit = candidate[i] ? sat_pos_literal(var) : sat_neg_literal(var);
+        Lit* assumption = sat_literal_complement(lit);
+        int ret = sat_solve_assuming_bounded(&assumption, 1, sat_state->backbone_conflicts, sat_state);
+        if (ret == 1) rule_out(i, candidate, known, sat_state);
+        else if (ret == -1) ++sat_state->n_backbone_gave_up;
+        else if (ret == 0) {
+            //the cnf is satisfiable, so lit holds in all of its models
+            BOOLEAN consistent = sat_unit_resolution(sat_state);
+            if (consistent && !sat_implied_literal(lit)) consistent = learn_unit(lit, sat_state);
+            sat_undo_unit_resolution(sat_state);
+            assert(consistent);
+        }
+        known[i] = 1;
+    }
+    free(candidate);
+    free(known);
+    return 1;
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//learns the units found by probing (and the backbone, if asked)
+//returns 0 if the cnf is found to be unsatisfiable, 1 otherwise
+BOOLEAN sat_probe(BOOLEAN backbone, SatState* sat_state) {
+    assert(sat_state->current_level == 1);
+    c2dSize n = sat_state->n;
+    Tree tree;
+    memset(&tree, 0, sizeof(Tree));
+    tree.parent  = malloc(sizeof(Lit*) * (2 * n + 1));
+    tree.depth   = malloc(sizeof(c2dSize) * (2 * n + 1));
+    tree.visited = calloc(2 * n + 1, sizeof(c2dSize));
+    tree.stack   = malloc(sizeof(Lit*) * (2 * n + 1));
+    tree.max_learned = HBR_MAX_LEARNED(n);
+    BOOLEAN consistent = sat_unit_resolution(sat_state) && probe_vars(&tree, sat_state);
+    sat_undo_unit_resolution(sat_state);
+    if (consistent) reduce_binaries(&tree, sat_state);
+    free(tree.parent);
+    free(tree.depth);
+    free(tree.visited);
+    free(tree.stack);
+    free(tree.binaries);
+    if (consistent && backbone) consistent = find_backbone(sat_state);
+    return consistent;
+}
+
+//a backbone query gives up after learning max_conflicts clauses (0: never)
+void sat_set_backbone_conflicts(c2dSize max_conflicts, SatState* sat_state) {
+    sat_state->backbone_conflicts = max_conflicts;
+}
+
+//returns the number of backbone candidates whose query gave up
+c2dSize sat_backbone_gave_up_count(const SatState* sat_state) {
+    return sat_state->n_backbone_gave_up;
+}
+
+//returns the number of binary clauses learned by hyper-binary resolution
+c2dSize sat_hyper_binary_count(const SatState* sat_state) {
+    return sat_state->n_hyper_binaries;
+}
+
+//returns the number of learned binary clauses removed by transitive reduction
+c2dSize sat_reduced_binary_count(const SatState* sat_state) {
+    return sat_state->n_reduced_binaries;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,168 @@
+#include "sat_api.h"
+#include <pthread.h>
+
+/******************************************************************************
+ * DRAT proofs
+ *
+ * An unsatisfiability proof lists the clauses the solver adds (each implied by
+ * the cnf and the earlier ones through unit resolution, RUP) and the clauses it
+ * deletes, ending with the empty clause. It is written in the binary DRAT format
+ * read by drat-trim:
+ * --'a' (addition) or 'd' (deletion), then the literals of the clause, then 0
+ * --literal l is the number 2|l| (+1 if l is negative), written 7 bits per byte,
+ *   least significant first, with the high bit set on all bytes but the last
+ *
+ * The solver only appends bytes to a buffer in memory. A full buffer is handed
+ * to a writer thread, which writes it to the file while the solver fills the
+ * other buffer, so the solver waits on the file only when it outpaces the disk.
+ *
+ * Every step of the solver that changes clauses must be checkable this way:
+ * learned clauses and vivified clauses are RUP, and so are the clauses added by
+ * preprocessing (resolvents, strengthened clauses, units and equivalences) and
+ * the units found by probing. XOR reasoning is not, so it is disabled while a
+ * proof is written (see xor_matrix_new()).
+ ******************************************************************************/
+
+#define PROOF_BUF_LEN (1 << 20) //bytes of each buffer
+
+struct proof {
+    FILE* file;
+    unsigned char* buf;     //buffer the solver fills
+    c2dSize size;
+    c2dSize buf_len;
+    unsigned char* out;     //buffer the writer thread writes
+    c2dSize out_size;
+    c2dSize out_len;
+    BOOLEAN pending;        //out is waiting to be written
+    BOOLEAN done;           //no more buffers will come
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static void* write_buffers(void* arg) {
+    Proof* proof = arg;
+    pthread_mutex_lock(&proof->lock);
+    while (1) {
+        while (!proof->pending && !proof->done) pthread_cond_wait(&proof->cond, &proof->lock);
+        if (!proof->pending) break;
+        pthread_mutex_unlock(&proof->lock);
+        fwrite(proof->out, 1, proof->out_size, proof->file);
+        pthread_mutex_lock(&proof->lock);
+        proof->pending = 0;
+        pthread_cond_signal(&proof->cond);
+    }
+    pthread_mutex_unlock(&proof->lock);
+    return NULL;
+}
+
+//hands the filled buffer to the writer thread
+static void flush(Proof* proof) {
+    pthread_mutex_lock(&proof->lock);
+    while (proof->pending) pthread_cond_wait(&proof->cond, &proof->lock);
+    unsigned char* out = proof->out;
+    c2dSize out_len = proof->out_len;
+    proof->out = proof->buf;
+    proof->out_len = proof->buf_len;
+    proof->out_size = proof->size;
+    proof->buf = out;
+    proof->buf_len = out_len;
+    proof->size = 0;
+    proof->pending = 1;
+    pthread_cond_signal(&proof->cond);
+    pthread_mutex_unlock(&proof->lock);
+}
+
+static void put_literal(Proof* proof, c2dLiteral lit) {
+    unsigned long u = lit > 0 ? 2 * (unsigned long)lit : 2 * (unsigned long)(-lit) + 1;
+    while (u > 127) {
+        proof->buf[proof->size++] = (unsigned char)(128 | (u & 127));
+        u >>= 7;
+    }
+    proof->buf[proof->size++] = (unsigned char)u;
+}
+
+//makes room in the buffer for a clause of size literals
+static void reserve(Proof* proof, c2dSize size) {
+    c2dSize needed = 2 + size * ((8 * sizeof(c2dLiteral) + 6) / 7);
+    if (proof->size + needed <= proof->buf_len) return;
+    if (proof->size > 0) flush(proof);
+    if (needed > proof->buf_len) {
+        proof->buf_len = needed;
+        proof->buf = realloc(proof->buf, proof->buf_len);
+    }
+}
+
+/******************************************************************************
+ * Steps
+ ******************************************************************************/
+
+//adds (step 'a') or deletes (step 'd') the clause with the given literals
+void proof_step(Proof* proof, char step, const c2dLiteral* lits, c2dSize size) {
+    if (proof == NULL) return;
+    reserve(proof, size);
+    proof->buf[proof->size++] = (unsigned char)step;
+    for(c2dSize i = 0; i < size; ++i) put_literal(proof, lits[i]);
+    proof->buf[proof->size++] = 0;
+}
+
+//adds (step 'a') or deletes (step 'd') a clause of the sat state
+void proof_clause_step(Proof* proof, char step, const Clause* clause) {
+    if (proof == NULL) return;
+    reserve(proof, clause->n_literals);
+    proof->buf[proof->size++] = (unsigned char)step;
+    for(c2dSize i = 0; i < clause->n_literals; ++i)
+        put_literal(proof, clause->literals[i]->index);
+    proof->buf[proof->size++] = 0;
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//starts writing a proof of unsatisfiability to the file
+//returns 0 if the file cannot be opened, 1 otherwise
+BOOLEAN sat_proof_open(const char* fname, SatState* sat_state) {
+    assert(sat_state->proof == NULL);
+    FILE* file = fopen(fname, "wb");
+    if (file == NULL) return 0;
+    Proof* proof = malloc(sizeof(Proof));
+    proof->file = file;
+    proof->buf_len = proof->out_len = PROOF_BUF_LEN;
+    proof->buf = malloc(proof->buf_len);
+    proof->out = malloc(proof->out_len);
+    proof->size = proof->out_size = 0;
+    proof->pending = proof->done = 0;
+    pthread_mutex_init(&proof->lock, NULL);
+    pthread_cond_init(&proof->cond, NULL);
+    pthread_create(&proof->writer, NULL, write_buffers, proof);
+    sat_state->proof = proof;
+
+    xor_matrix_free(sat_state->xor_matrix);
+    sat_state->xor_matrix = NULL;
+    return 1;
+}
+
+//ends the proof with the empty clause if unsat is 1, and closes its file
+void sat_proof_close(BOOLEAN unsat, SatState* sat_state) {
+    Proof* proof = sat_state->proof;
+    if (proof == NULL) return;
+    if (unsat) proof_step(proof, 'a', NULL, 0);
+    if (proof->size > 0) flush(proof);
+    pthread_mutex_lock(&proof->lock);
+    proof->done = 1;
+    pthread_cond_signal(&proof->cond);
+    pthread_mutex_unlock(&proof->lock);
+    pthread_join(proof->writer, NULL);
+    pthread_mutex_destroy(&proof->lock);
+    pthread_cond_destroy(&proof->cond);
+    fclose(proof->file);
+    free(proof->buf);
+    free(proof->out);
+    free(proof);
+    sat_state->proof = NULL;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -11,6 +11,57 @@
  * --You should carefully read the descriptions and must follow each requirement
  ******************************************************************************/
 
+/******************************************************************************
+ * Allocation checks (see sat_api.h)
+ ******************************************************************************/
+
+#ifdef SAT_ALLOC_CHECK
+AllocStats sat_alloc_stats;
+
+void* alloc_counted(void* ptr) {
+    ++sat_alloc_stats.allocs;
+    return ptr;
+}
+
+//counts an operation of kind op, and aborts if it allocated anything but growing
+//buffers and the clause it learned (the clause and its literals)
+static void alloc_check(int op, unsigned long allocs, unsigned long growths,
+                        const Clause* learned, const SatState* sat_state) {
+    static const char* names[ALLOC_OPS] = {"decision", "assertion", "undo"};
+    allocs = sat_alloc_stats.allocs - allocs;
+    growths = sat_alloc_stats.growths - growths;
+    ++sat_alloc_stats.ops[op];
+    sat_alloc_stats.op_allocs[op] += allocs;
+    if (sat_state->proof != NULL) return; //the proof allocates its own buffers
+    if (allocs - growths > (learned != NULL ? 2 : 0)) {
+        fprintf(stderr, "\nlibsat: %lu allocations in steady state by one %s\n",
+                allocs - growths, names[op]);
+        abort();
+    }
+}
+
+//prints the number of operations of each kind, and the allocations they made
+void sat_print_alloc_stats(void) {
+    static const char* names[ALLOC_OPS] = {"Decisions", "Assertions", "Undos"};
+    printf("\nAllocation stats:");
+    for(int op = 0; op < ALLOC_OPS; ++op) {
+        unsigned long ops = sat_alloc_stats.ops[op];
+        printf("\n  %-10s\t%lu (%0.4f allocations each)", names[op], ops,
+               ops ? (double)sat_alloc_stats.op_allocs[op] / ops : 0.0);
+    }
+    printf("\n  Allocations\t%lu (%lu growing reused buffers)\n",
+           sat_alloc_stats.allocs, sat_alloc_stats.growths);
+}
+
+#define ALLOC_CHECK_BEGIN() \
+    unsigned long allocs_before = sat_alloc_stats.allocs, growths_before = sat_alloc_stats.growths
+#define ALLOC_CHECK_END(op, learned, sat_state) \
+    alloc_check(op, allocs_before, growths_before, learned, sat_state)
+#else
+#define ALLOC_CHECK_BEGIN()
+#define ALLOC_CHECK_END(op, learned, sat_state)
+#endif
+
 /******************************************************************************
  * Variables
  ******************************************************************************/
@@ -21,6 +72,7 @@ Var* Var_new(c2dSize id) {
     var->clauses = NULL;
     var->n_clauses = 0;
     var->clauses_buf_len = 0;
+    var->phase = 1;
     var->mark = 0;
     return var;
 }
@@ -91,6 +143,8 @@ Lit* Lit_new(c2dLiteral id) {
     literal->decision_level = 0;
     literal->implied_by = NULL;
     literal->n_implied_by = 0;
+    literal->implied_by_buf_len = 0;
+    literal->reason = NULL;
     literal->clauses = NULL;
     literal->n_clauses = 0;
     literal->clauses_buf_len = 0;
@@ -100,6 +154,7 @@ Lit* Lit_new(c2dLiteral id) {
 void Lit_delete(Lit* lit) {
     if (lit) {
         if (lit->implied_by) free(lit->implied_by);
+        if (lit->clauses) free(lit->clauses);
         free(lit);
     }
 }
@@ -109,6 +164,7 @@ LitNode* LitNode_new(Lit* literal, LitNode* prev, LitNode* next) {
     node->literal = literal;
     node->prev = prev;
     node->next = next;
+    node->trail = NULL;
     return node;
 }
 
@@ -118,6 +174,49 @@ void LitNode_delete(LitNode* node) {
     }
 }
 
+//trail nodes are carved from blocks that grow with the trail (each as large as
+//all the blocks before it), so a long trail sits on a few large tables
+struct node_slab {
+    NodeSlab* next;
+    size_t size;                    //number of nodes
+    LitNode nodes[];
+};
+
+//adds a block of nodes to the free nodes of sat state
+static void grow_nodes(SatState* sat_state) {
+    size_t size = 0;
+    for(NodeSlab* slab = sat_state->node_slabs; slab != NULL; slab = slab->next) size += slab->size;
+    if (size == 0) size = 64;
+    NodeSlab* slab = sat_large_alloc(sizeof(NodeSlab) + sizeof(LitNode) * size);
+    ALLOC_GROWTH(1);
+    slab->size = size;
+    slab->next = sat_state->node_slabs;
+    sat_state->node_slabs = slab;
+    for(size_t i = size; i > 0; --i) {
+        slab->nodes[i - 1].prev = sat_state->free_nodes;
+        sat_state->free_nodes = &slab->nodes[i - 1];
+    }
+}
+
+//returns a node for lit at the end of a list of the trail, reusing a node undone
+//earlier if there is one
+LitNode* trail_node_new(Lit* lit, LitNode* prev, SatState* sat_state) {
+    if (sat_state->free_nodes == NULL) grow_nodes(sat_state);
+    LitNode* node = sat_state->free_nodes;
+    sat_state->free_nodes = node->prev;
+    node->literal = lit;
+    node->prev = prev;
+    node->next = NULL;
+    node->trail = NULL;
+    return node;
+}
+
+//keeps an undone node of the trail for reuse (the free nodes are chained by prev)
+static void node_release(LitNode* node, SatState* sat_state) {
+    node->prev = sat_state->free_nodes;
+    sat_state->free_nodes = node;
+}
+
 //returns a literal structure for the corresponding index
 Lit* sat_index2literal(c2dLiteral index, const SatState* sat_state) {
     if (index > 0) {
@@ -132,6 +231,11 @@ c2dLiteral sat_literal_index(const Lit* lit) {
     return lit->index;
 }
 
+//returns the complement of a literal
+Lit* sat_literal_complement(const Lit* lit) {
+    return lit->index > 0 ? lit->var->neg_literal : lit->var->pos_literal;
+}
+
 //returns the positive literal of a variable
 Lit* sat_pos_literal(const Var* var) {
     return var->pos_literal;
@@ -148,22 +252,25 @@ BOOLEAN sat_implied_literal(const Lit* lit) {
     return lit->decision_level > 0;
 }
 
+//returns the literal of a variable that agrees with its saved phase
+Lit* sat_phase_literal(const Var* var) {
+    return var->phase ? var->pos_literal : var->neg_literal;
+}
+
 void modify_n_false(Lit* lit, SatState* sat_state, c2dLiteral x) {
     Lit* comp_lit = sat_index2literal(-sat_literal_index(lit), 
         sat_state);
     for(c2dSize i = 0; i < comp_lit->n_clauses; ++i)
         comp_lit->clauses[i]->n_false += x;
+    if (sat_state->card_set != NULL) card_count(lit, sat_state, x);
 }
 
-//sets the literal to true, and then runs unit resolution
-//returns a learned clause if unit resolution detected a contradiction, NULL otherwise
-//
-//if the current decision level is L in the beginning of the call, it should be updated 
-//to L+1 so that the decision level of lit and all other literals implied by unit resolution is L+1
-Clause* sat_decide_literal(Lit* lit, SatState* sat_state) {
+//opens a new decision level, with lit as its decision (unit resolution is not run)
+static void open_level(Lit* lit, SatState* sat_state) {
     ++sat_state->current_level;
     lit->decision_level = sat_state->current_level;
-    LitNode* node = LitNode_new(lit, sat_state->decided_literals, NULL);
+    LitNode* node = trail_node_new(lit, sat_state->decided_literals, sat_state);
+    node->trail = sat_state->implied_literals;
     if (sat_state->decided_literals != NULL)
         sat_state->decided_literals->next = node;
     sat_state->decided_literals = node;
@@ -172,15 +279,87 @@ Clause* sat_decide_literal(Lit* lit, SatState* sat_state) {
         if (lit->clauses[i]->subsumed_level == 0)
             lit->clauses[i]->subsumed_level = sat_state->current_level;
     modify_n_false(lit, sat_state, 1);
+}
+
+//sets the literal to true, and then runs unit resolution
+//returns a learned clause if unit resolution detected a contradiction, NULL otherwise
+//
+//if the current decision level is L in the beginning of the call, it should be updated 
+//to L+1 so that the decision level of lit and all other literals implied by unit resolution is L+1
+Clause* sat_decide_literal(Lit* lit, SatState* sat_state) {
+    ALLOC_CHECK_BEGIN();
+    open_level(lit, sat_state);
 
     //printf("literal %ld decided at level %ld\n",node->literal->index, sat_state->current_level);
     sat_state->from_decision = 1;
-    if (sat_unit_resolution(sat_state)) {
-        sat_state->asserted_clause = NULL;
-        return NULL;
-    } else {
+    if (sat_unit_resolution(sat_state)) sat_state->asserted_clause = NULL;
+    ALLOC_CHECK_END(ALLOC_DECIDE, sat_state->asserted_clause, sat_state);
+    return sat_state->asserted_clause;
+}
+
+static void size_analysis(SatState* sat_state);
+
+//returns the clause learned when lit is false but not a decision: the reason of
+//its complement without the literals false at level 1, asserted at the level of
+//the latest of them (so that it implies the complement there)
+static Clause* false_literal_clause(Lit* lit, SatState* sat_state) {
+    Lit* comp = sat_literal_complement(lit);
+    assert(comp->decision_level == 1 || comp->n_implied_by > 0);
+    c2dSize n = sat_state->n;
+    size_analysis(sat_state);
+    Lit** literals = malloc(sizeof(Lit*) * (comp->n_implied_by + 1));
+    c2dSize count = 0;
+    c2dSize assertion_level = 1;
+    for(c2dSize i = 0; i < comp->n_implied_by; ++i) {
+        Lit* cause = comp->implied_by[i];
+        if (cause->decision_level <= 1 || sat_state->seen[cause->index + n]) continue;
+        sat_state->seen[cause->index + n] = 1;
+        literals[count++] = sat_literal_complement(cause);
+        if (cause->decision_level > assertion_level) assertion_level = cause->decision_level;
+    }
+    for(c2dSize i = 0; i < count; ++i) sat_state->seen[-literals[i]->index + n] = 0;
+    literals[count++] = comp;
+    Clause* clause = Clause_new(sat_clause_count(sat_state) +
+        sat_learned_clause_count(sat_state) + 1, literals, count, sat_state->m);
+    clause->assertion_level = assertion_level;
+    return clause;
+}
+
+//sets the literals lits[0..k-1] to true, each at a new decision level (skipping
+//the ones already true), and then runs unit resolution for all of them at once
+//returns a learned clause if unit resolution detected a contradiction, NULL otherwise
+//
+//a literal implied gets the level of the latest decision it depends on
+//
+//a literal already false is the first contradiction: no level is opened, and the
+//clause learned is the reason of its complement
+Clause* sat_decide_literals(Lit** lits, c2dSize k, SatState* sat_state) {
+    ALLOC_CHECK_BEGIN();
+    for(c2dSize i = 0; i < k; ++i) {
+        if (!sat_implied_literal(sat_literal_complement(lits[i]))) continue;
+        sat_state->asserted_clause = false_literal_clause(lits[i], sat_state);
+        ALLOC_CHECK_END(ALLOC_DECIDE, sat_state->asserted_clause, sat_state);
         return sat_state->asserted_clause;
     }
+    LitNode* first = NULL;
+    for(c2dSize i = 0; i < k; ++i) {
+        if (sat_implied_literal(lits[i])) continue;
+        open_level(lits[i], sat_state);
+        if (first == NULL) first = sat_state->decided_literals;
+    }
+    if (first != NULL && first == sat_state->decided_literals) { //a single decision
+        sat_state->from_decision = 1;
+        if (sat_unit_resolution(sat_state)) sat_state->asserted_clause = NULL;
+    } else {
+        Clause* conflict = NULL;
+        for(LitNode* node = first; node != NULL && conflict == NULL; node = node->next)
+            conflict = unit_resolution_helper(sat_index2literal(-node->literal->index, sat_state),
+                                              sat_state);
+        if (conflict == NULL && sat_state->xor_matrix != NULL) conflict = xor_propagate(sat_state);
+        sat_state->asserted_clause = conflict ? construct_asserted_clause(conflict, sat_state) : NULL;
+    }
+    ALLOC_CHECK_END(ALLOC_DECIDE, sat_state->asserted_clause, sat_state);
+    return sat_state->asserted_clause;
 }
 
 //undoes the last literal decision and the corresponding implications obtained by unit resolution
@@ -188,56 +367,112 @@ Clause* sat_decide_literal(Lit* lit, SatState* sat_state) {
 //if the current decision level is L in the beginning of the call, it should be updated 
 //to L-1 before the call ends
 void sat_undo_decide_literal(SatState* sat_state) {
-    LitNode* cur = sat_state->decided_literals;
-    sat_state->decided_literals = cur->prev;
-   
-    // clear all the subsumed clause
-    // this is incorrect? - Sheng
-    for (c2dSize i = 0; i < cur->literal->n_clauses; i ++) {
-        Clause* clause = cur->literal->clauses[i];
-        if (clause->subsumed_level == sat_state->current_level)
+    sat_undo_to_level(sat_state->current_level - 1, sat_state);
+}
+
+//un-instantiates lit, which was set above level, saving its phase
+//(the clauses it subsumed above level are no longer subsumed)
+static void undo_literal(Lit* lit, c2dSize level, SatState* sat_state) {
+    for (c2dSize i = 0; i < lit->n_clauses; i ++) {
+        Clause* clause = lit->clauses[i];
+        if (clause->subsumed_level > level)
             clause->subsumed_level = 0;
     }
-    modify_n_false(cur->literal, sat_state, -1);
-    
-    cur->literal->decision_level = 0;
+    modify_n_false(lit, sat_state, -1);
+    lit->decision_level = 0;
+    lit->var->phase = lit->index > 0;
+    lit->n_implied_by = 0; //implied_by is kept for the next implication
+    lit->reason = NULL;
+}
+
+//un-instantiates the implied literals set above level, walking the trail back from
+//its end to stop (exclusive, NULL for the start of the trail)
+//
+//literals set above level all come after the decision of level+1, as the trail
+//is only appended to, and stop is the end of the trail at that decision; literals
+//of lower levels met on the way were implied out of order, and are kept
+static void undo_implied(c2dSize level, LitNode* stop, SatState* sat_state) {
+    LitNode* cur = sat_state->implied_literals;
+    while (cur != stop) {
+        LitNode* prev = cur->prev;
+        if (cur->literal->decision_level > level) {
+            undo_literal(cur->literal, level, sat_state);
+            LitNode* next = cur->next;
+            if (prev != NULL) prev->next = next;
+            if (next != NULL) next->prev = prev;
+            if (next == NULL) sat_state->implied_literals = prev;
+            node_release(cur, sat_state);
+        }
+        cur = prev;
+    }
+}
+
+//undoes the decisions above level, and the implications obtained by unit resolution at
+//those levels, in a single pass over the literals they set (level is at least 1)
+void sat_undo_to_level(c2dSize level, SatState* sat_state) {
+    assert(level >= 1 && level <= sat_state->current_level);
+    if (level == sat_state->current_level) return;
+    ALLOC_CHECK_BEGIN();
+    //the decision of level+1, whose trail mark bounds the walk
+    LitNode* first = sat_state->decided_literals;
+    while (first->literal->decision_level > level + 1) first = first->prev;
+    LitNode* stop = first->trail;
+    trail_save(level, sat_state);
+
+    while (sat_state->current_level > level) {
+        LitNode* cur = sat_state->decided_literals;
+        sat_state->decided_literals = cur->prev;
+        undo_literal(cur->literal, level, sat_state);
+        node_release(cur, sat_state);
+        --sat_state->current_level;
+    }
     if (sat_state->decided_literals != NULL)
         sat_state->decided_literals->next = NULL;
-    LitNode_delete(cur);
-    //printf("literal %ld undecided at level %ld\n",cur->literal->index, sat_state->current_level);
-    sat_undo_unit_resolution(sat_state);
-    --sat_state->current_level;
+    undo_implied(level, stop, sat_state);
+    ALLOC_CHECK_END(ALLOC_UNDO, NULL, sat_state);
 }
 
+// the literal is implied at the highest level of the literals it is implied by,
+// which is below the current level when a clause is asserted after a
+// chronological backtrack (the literal is then out of order in the trail)
 void imply_literal(Lit* unset_lit, Clause* clause, SatState* sat_state) {
-    // set implied literal
-    unset_lit->decision_level = sat_state->current_level;
+    c2dSize level = 1;
     // if not unit clause
     if (sat_clause_size(clause) != 1) {
-        Lit** implied_by_array = malloc(sizeof(Lit*) * 
-                (sat_clause_size(clause) - 1));
+        if (unset_lit->implied_by_buf_len < sat_clause_size(clause) - 1) {
+            ALLOC_GROWTH(1);
+            unset_lit->implied_by_buf_len = sat_clause_size(clause) - 1;
+            unset_lit->implied_by = realloc(unset_lit->implied_by,
+                sizeof(Lit*) * unset_lit->implied_by_buf_len);
+        }
+        Lit** implied_by_array = unset_lit->implied_by;
         c2dSize temp = 0;
         Lit** lits = sat_clause_literals(clause);
         for(c2dSize i = 0; i < sat_clause_size(clause); ++i) {
             if (lits[i] == unset_lit) continue;
-            implied_by_array[temp++] = 
+            implied_by_array[temp] = 
                 sat_index2literal(-sat_literal_index(lits[i]),sat_state);
+            if (implied_by_array[temp]->decision_level > level)
+                level = implied_by_array[temp]->decision_level;
+            ++temp;
         }
-        unset_lit->implied_by = implied_by_array;
         unset_lit->n_implied_by = sat_clause_size(clause) - 1;
     }
-    LitNode * lnode = LitNode_new(unset_lit, sat_state->implied_literals, 
-        NULL);
+    unset_lit->reason = clause;
+    // set implied literal
+    unset_lit->decision_level = level;
+    LitNode * lnode = trail_node_new(unset_lit, sat_state->implied_literals, sat_state);
     if (sat_state->implied_literals != NULL) {
         sat_state->implied_literals->next = lnode;
     }
     sat_state->implied_literals = lnode;
     //printf("literal %ld implied\n", unset_lit->index);
     // recursively search
+    // (a clause is subsumed at the lowest level of its true literals)
     for(c2dSize i = 0; i < unset_lit->n_clauses; ++i)
-        if (unset_lit->clauses[i]->subsumed_level == 0)
-            unset_lit->clauses[i]->subsumed_level = 
-                sat_state->current_level;
+        if (unset_lit->clauses[i]->subsumed_level == 0 ||
+            unset_lit->clauses[i]->subsumed_level > level)
+            unset_lit->clauses[i]->subsumed_level = level;
     modify_n_false(unset_lit, sat_state, 1);
 } 
 
@@ -255,6 +490,7 @@ Clause* Clause_new(c2dSize id, Lit** literals, c2dSize n_literals, c2dSize m) {
         Var* var = sat_literal_var(literals[i]);
         // var
         if (id <= m) {
+            if (var->n_clauses == var->clauses_buf_len) ALLOC_GROWTH(1);
             if (var->clauses_buf_len == 0) {
                 var->clauses_buf_len = 1;
                 var->n_clauses = 1;
@@ -276,6 +512,7 @@ Clause* Clause_new(c2dSize id, Lit** literals, c2dSize n_literals, c2dSize m) {
         }
         // literal
         Lit* lit = literals[i];
+        if (lit->n_clauses == lit->clauses_buf_len) ALLOC_GROWTH(1);
         if (lit->clauses_buf_len == 0) {
             lit->clauses_buf_len = 1;
             lit->n_clauses = 1;
@@ -298,6 +535,7 @@ Clause* Clause_new(c2dSize id, Lit** literals, c2dSize n_literals, c2dSize m) {
     clause->subsumed_level = 0;
     clause->assertion_level = 1;
     clause->mark = 0;
+    clause->detached = 0;
     clause->n_false = 0;
     if (n_literals > 1) {
         clause->watch_lit1 = literals[0];
@@ -357,6 +595,11 @@ c2dSize sat_clause_size(const Clause* clause) {
 
 //returns 1 if the clause is subsumed, 0 otherwise
 BOOLEAN sat_subsumed_clause(const Clause* clause) {
+    if (clause->detached) { //not kept up to date by unit resolution
+        for(c2dSize i = 0; i < clause->n_literals; ++i)
+            if (sat_implied_literal(clause->literals[i])) return 1;
+        return 0;
+    }
     return clause->subsumed_level > 0;
 }
 
@@ -375,7 +618,13 @@ c2dSize sat_learned_clause_count(const SatState* sat_state) {
 //
 //this function is called on a clause returned by sat_decide_literal() or sat_assert_clause()
 //moreover, it should be called only if sat_at_assertion_level() succeeds
+//
+//at level 1, the learned clauses are vivified once enough of them are new
+//(see sat_set_vivify_interval())
 Clause* sat_assert_clause(Clause* clause, SatState* sat_state) {
+    ALLOC_CHECK_BEGIN();
+    proof_clause_step(sat_state->proof, 'a', clause);
+    if (sat_state->n_learned_clauses == sat_state->learned_clauses_buf_len) ALLOC_GROWTH(1);
     if (sat_state->learned_clauses_buf_len == 0) {
         sat_state->learned_clauses_buf_len = 1;
         sat_state->n_learned_clauses = 1;
@@ -401,8 +650,14 @@ Clause* sat_assert_clause(Clause* clause, SatState* sat_state) {
                     sat_learned_clause_count(sat_state);
     if (sat_unit_resolution(sat_state)) {
         sat_state->asserted_clause = NULL;
+        ALLOC_CHECK_END(ALLOC_ASSERT, NULL, sat_state); //vivification is not checked
+        if (sat_state->vivify_interval > 0 && sat_state->current_level == 1 &&
+            sat_state->n_learned_clauses >= sat_state->n_vivified + sat_state->vivify_interval &&
+            !sat_vivify(sat_state))
+            return sat_state->asserted_clause;
         return NULL;
     } else {
+        ALLOC_CHECK_END(ALLOC_ASSERT, sat_state->asserted_clause, sat_state);
         return sat_state->asserted_clause;
     }
 }
@@ -428,113 +683,150 @@ Clause* sat_assert_clause(Clause* clause, SatState* sat_state) {
  ******************************************************************************/
 
 
-char* read_next_number(char* p, long* num) {
-    long sign = 1;
-    *num = 0;
-    while (*p && !(*p >= '0' && *p <= '9') && *p != '-') ++p;
-    if (*p == '-') {
-        sign = -1;
-        ++p;
-    }
-    while (*p >= '0' && *p <= '9') {
-        *num = *num * 10 + (*p - '0');
-        ++p;
-    }
-    *num = *num * sign;
-    return p;
-}
-
 void print_state(SatState* state) {
     printf("# of variables: %lu\n", state->n);
     printf("# of input clauses: %lu\n", state->m);
     for(c2dSize i = 0; i < state->m; ++i) {
         for(c2dSize j = 0; j < state->CNF_clauses[i]->n_literals; ++j)
-            printf("%ld ", state->CNF_clauses[i]->literals[j]->index);
+            printf("%ld ", (c2dLiteral)state->CNF_clauses[i]->literals[j]->index);
         printf("\n");
     }
     printf("end\n");
 }
 
 
+static SatState* state_new(const Formula* formula);
+
 //constructs a SatState from an input cnf file
+//
+//the formula read is freed once the clauses are built: the sat state captures its
+//cnf again only if it is about to change it (see formula_capture())
 SatState* sat_state_new(const char* file_name) {
-    FILE *fp = fopen(file_name, "r");
-    if (fp == NULL) {
-        printf("Error: file %s cannot be open", file_name);
-        return NULL;
+    Formula* formula = formula_read(file_name);
+    if (formula == NULL) return NULL;
+    SatState* state = state_new(formula);
+    formula_release(formula);
+    return state;
+}
+
+//constructs the cnf clauses of sat state from a formula
+static void load_clauses(const Formula* formula, SatState* sat_state) {
+    for(c2dSize i = 1; i <= sat_state->m; ++i) {
+        c2dSize n_literals;
+        const c2dLiteral* indices = formula_clause(i - 1, &n_literals, formula);
+        Lit** literals = malloc(sizeof(Lit*) * n_literals);
+        for(c2dSize j = 0; j < n_literals; ++j)
+            literals[j] = sat_index2literal(indices[j], sat_state);
+        sat_state->CNF_clauses[i - 1] = Clause_new(i, literals, n_literals, sat_state->m);
     }
+}
+
+//constructs a SatState from the cnf of a formula, holding no reference to it
+static SatState* state_new(const Formula* formula) {
     SatState* state = malloc(sizeof(SatState));
-    char* line = (char*)malloc(sizeof(char) * (BUF_LEN + 5));
-    char* ptr = line;
-    while (fgets(line, BUF_LEN, fp) != NULL) {
-        if (line[0] != 'p') continue;
-        else {
-            c2dLiteral tmp;
-            line = read_next_number(line, &tmp);
-            state->n = (c2dSize)tmp;
-            line = read_next_number(line, &tmp);
-            state->m = (c2dSize)tmp;
-            // initialize n variables and literals
-            state->variables = malloc(sizeof(Var*) * state->n);
-            state->pos_literals = malloc(sizeof(Lit*) * state->n);
-            state->neg_literals = malloc(sizeof(Lit*) * state->n);
-            for(c2dSize i = 1; i <= state->n; ++i) {
-                state->variables[i - 1] = Var_new(i);
-                state->pos_literals[i - 1] = Lit_new((c2dLiteral)i);
-                state->neg_literals[i - 1] = Lit_new(-((c2dLiteral)i));
-                state->variables[i - 1]->pos_literal = state->pos_literals[i - 1];
-                state->variables[i - 1]->neg_literal = state->neg_literals[i - 1];
-                state->pos_literals[i - 1]->var = state->variables[i - 1];
-                state->neg_literals[i - 1]->var = state->variables[i - 1];
-            }
-            state->n_learned_clauses = 0;
-            state->CNF_clauses = malloc(sizeof(Clause*) * state->m);
-            state->learned_clauses_buf_len = 0;
-            state->learned_clauses = NULL;
-            state->decided_literals = NULL;
-            state->implied_literals = NULL;
-            state->asserted_clause = NULL;
-            for(c2dSize i = 1; i <= state->m; ++i) {
-                line = ptr; // restore start position of buffer
-                fgets(line, BUF_LEN, fp);
-                c2dSize n_literals = 0;
-                while (1) {
-                    line = read_next_number(line, &tmp);
-                    if (tmp == 0) break;
-                    ++n_literals;
-                }
-                if (n_literals == 0) {
-                    --i;
-                    continue;
-                }
-                Lit** literals = malloc(sizeof(Lit*) * n_literals);
-                line = ptr;
-                for(c2dSize j = 0; j < n_literals; ++j) {
-                    line = read_next_number(line, &tmp);
-                    Lit* lit = NULL;
-                    if (tmp > 0)
-                        lit = sat_pos_literal(sat_index2var(tmp, state));
-                    else
-                        lit = sat_neg_literal(sat_index2var(-tmp, state));
-                    literals[j] = lit;
-                }
-                state->CNF_clauses[i - 1] = Clause_new(i, literals, 
-                                                  n_literals, state->m);
-            }
-            break; //while
-        }
-        line = ptr; // restore start position of buffer
+    state->formula = NULL;
+    state->n = formula_var_count(formula);
+    state->m = formula_clause_count(formula);
+    assert(state->n <= C2D_INDEX_MAX && state->m <= C2D_INDEX_MAX); //see c2dIndex
+    // initialize n variables and literals
+    state->variables = malloc(sizeof(Var*) * state->n);
+    state->pos_literals = malloc(sizeof(Lit*) * state->n);
+    state->neg_literals = malloc(sizeof(Lit*) * state->n);
+    for(c2dSize i = 1; i <= state->n; ++i) {
+        state->variables[i - 1] = Var_new(i);
+        state->pos_literals[i - 1] = Lit_new((c2dLiteral)i);
+        state->neg_literals[i - 1] = Lit_new(-((c2dLiteral)i));
+        state->variables[i - 1]->pos_literal = state->pos_literals[i - 1];
+        state->variables[i - 1]->neg_literal = state->neg_literals[i - 1];
+        state->pos_literals[i - 1]->var = state->variables[i - 1];
+        state->neg_literals[i - 1]->var = state->variables[i - 1];
     }
-    free(ptr);
-    fclose(fp);
+    state->n_learned_clauses = 0;
+    state->CNF_clauses = malloc(sizeof(Clause*) * state->m);
+    state->learned_clauses_buf_len = 0;
+    state->learned_clauses = NULL;
+    state->decided_literals = NULL;
+    state->implied_literals = NULL;
+    state->asserted_clause = NULL;
+    state->empty_clause = NULL;
+    state->failed_assumptions = NULL;
+    state->n_failed_assumptions = 0;
+    state->assumption_failed = 0;
+    state->query_conflicts = 0;
+    state->query_gave_up = 0;
+    state->model = calloc(state->n + 1, sizeof(BOOLEAN));
+    state->chrono_threshold = 0;
+    state->vivify_interval = 0;
+    state->n_vivified = 0;
+    state->elim_stack = NULL;
+    state->n_substituted = 0;
+    state->n_hyper_binaries = 0;
+    state->n_reduced_binaries = 0;
+    state->backbone_conflicts = BACKBONE_MAX_CONFLICTS;
+    state->n_backbone_gave_up = 0;
+    state->proof = NULL;
+    state->vivifying = 0;
+    state->saved_trail = NULL;
+    state->extended = 0;
+    state->free_nodes = NULL;
+    state->node_slabs = NULL;
+    state->seen = NULL;
+    state->marked_lits = NULL;
+    state->analysis_lits = NULL;
+    state->resolved = NULL;
+    state->analysis_n = 0;
+    load_clauses(formula, state);
     state->current_level = 1;
     state->from_decision = 0;
+    state->xor_matrix = xor_matrix_new(state);
+    state->card_set = card_set_new(state);
     //print_state(state);
     return state;
 }
 
+//returns the clause learned from the last contradiction if it was not asserted
+//(it is then owned by no list of sat state), NULL otherwise
+static Clause* pending_clause(const SatState* sat_state) {
+    Clause* clause = sat_state->asserted_clause;
+    if (clause == NULL || clause == sat_state->empty_clause) return NULL;
+    c2dSize m = sat_state->m;
+    if (clause->index > m && clause->index <= m + sat_state->n_learned_clauses &&
+        sat_state->learned_clauses[clause->index - m - 1] == clause) return NULL;
+    return clause;
+}
+
+//returns the nodes of the trail to the free nodes
+static void free_trail(SatState* sat_state) {
+    LitNode* literals = sat_state->decided_literals;
+    while (literals != NULL) {
+        LitNode* del = literals;
+        literals = literals->prev;
+        node_release(del, sat_state);
+    }
+    literals = sat_state->implied_literals;
+    while (literals != NULL) {
+        LitNode* del = literals;
+        literals = literals->prev;
+        node_release(del, sat_state);
+    }
+    sat_state->decided_literals = NULL;
+    sat_state->implied_literals = NULL;
+}
+
+static void free_node_slabs(SatState* sat_state) {
+    NodeSlab* slab = sat_state->node_slabs;
+    while (slab != NULL) {
+        NodeSlab* del = slab;
+        slab = slab->next;
+        sat_large_free(del, sizeof(NodeSlab) + sizeof(LitNode) * del->size);
+    }
+    sat_state->node_slabs = NULL;
+    sat_state->free_nodes = NULL;
+}
+
 //frees the SatState
 void sat_state_free(SatState* sat_state) {
+    Clause_delete(pending_clause(sat_state));
     for(c2dSize i = 0; i < sat_state->n; ++i) {
         Var_delete(sat_state->variables[i]);
         Lit_delete(sat_state->pos_literals[i]);
@@ -551,18 +843,120 @@ void sat_state_free(SatState* sat_state) {
         Clause_delete(sat_state->learned_clauses[i]);
     }
     free(sat_state->learned_clauses);
-    LitNode* literals = sat_state->decided_literals;
-    while (literals != NULL) {
-        LitNode* del = literals;
-        literals = literals->prev;
-        LitNode_delete(del);
+    Clause_delete(sat_state->empty_clause);
+    free(sat_state->failed_assumptions);
+    free(sat_state->model);
+    xor_matrix_free(sat_state->xor_matrix);
+    card_set_free(sat_state->card_set);
+    elim_stack_free(sat_state->elim_stack);
+    sat_proof_close(0, sat_state);
+    saved_trail_free(sat_state->saved_trail);
+    formula_release(sat_state->formula);
+    free_node_slabs(sat_state);
+    free(sat_state->seen);
+    free(sat_state->marked_lits);
+    free(sat_state->analysis_lits);
+    free(sat_state->resolved);
+    free(sat_state);
+}
+
+//returns sat state to its condition right after its construction from its formula
+//
+//the variables, literals and the arrays holding them are reused, so this takes time
+//linear in the size of the cnf (and of the learned clauses kept)
+void sat_state_reset(BOOLEAN keep_learned, SatState* sat_state) {
+    //a sat state without a formula still has its cnf, which is rebuilt from a copy
+    Formula* formula = formula_of_state(sat_state);
+    c2dSize n = formula_var_count(formula);
+    c2dSize m = formula_clause_count(formula);
+    //clauses learned with the constraints of symmetry breaking, or with clauses
+    //added since construction, may not follow from the cnf
+    if (sat_state->extended) keep_learned = 0;
+    sat_state->extended = 0;
+
+    sat_proof_close(0, sat_state);
+    trail_forget(sat_state);
+    free_trail(sat_state);
+    Clause_delete(pending_clause(sat_state));
+    sat_state->asserted_clause = NULL;
+    Clause_delete(sat_state->empty_clause);
+    sat_state->empty_clause = NULL;
+
+    //variables added since construction
+    for(c2dSize i = n; i < sat_state->n; ++i) {
+        Var_delete(sat_state->variables[i]);
+        Lit_delete(sat_state->pos_literals[i]);
+        Lit_delete(sat_state->neg_literals[i]);
     }
-    literals = sat_state->implied_literals;
-    while (literals != NULL) {
-        LitNode* del = literals;
-        literals = literals->prev;
-        LitNode_delete(del);
+    if (sat_state->n != n) {
+        sat_state->variables = realloc(sat_state->variables, sizeof(Var*) * n);
+        sat_state->pos_literals = realloc(sat_state->pos_literals, sizeof(Lit*) * n);
+        sat_state->neg_literals = realloc(sat_state->neg_literals, sizeof(Lit*) * n);
+        sat_state->model = realloc(sat_state->model, sizeof(BOOLEAN) * (n + 1));
+        sat_state->n = n;
+    }
+    for(c2dSize i = 0; i < n; ++i) {
+        Var* var = sat_state->variables[i];
+        var->n_clauses = 0;
+        var->phase = 1;
+        var->mark = 0;
+        Lit* lits[2] = {sat_state->pos_literals[i], sat_state->neg_literals[i]};
+        for(int j = 0; j < 2; ++j) {
+            lits[j]->decision_level = 0;
+            lits[j]->n_implied_by = 0;
+            lits[j]->reason = NULL;
+            lits[j]->n_clauses = 0;
+        }
+    }
+    memset(sat_state->model, 0, sizeof(BOOLEAN) * (n + 1));
+
+    for(c2dSize i = 0; i < sat_state->m; ++i) Clause_delete(sat_state->CNF_clauses[i]);
+    if (sat_state->m != m)
+        sat_state->CNF_clauses = realloc(sat_state->CNF_clauses, sizeof(Clause*) * (m + 1));
+    sat_state->m = m;
+    load_clauses(formula, sat_state);
+    formula_release(formula);
+
+    //the learned clauses kept get back into the occurrence lists of their literals,
+    //numbered after the cnf clauses
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses; ++i) {
+        Clause* clause = sat_state->learned_clauses[i];
+        if (keep_learned) {
+            sat_state->learned_clauses[i] = Clause_new(m + i + 1, clause->literals,
+                                                       clause->n_literals, m);
+            free(clause);
+        } else Clause_delete(clause);
+    }
+    if (!keep_learned) {
+        sat_state->n_learned_clauses = 0;
+        sat_state->n_vivified = 0;
     }
+
+    free(sat_state->failed_assumptions);
+    sat_state->failed_assumptions = NULL;
+    sat_state->n_failed_assumptions = 0;
+    sat_state->assumption_failed = 0;
+    sat_state->query_conflicts = 0;
+    sat_state->query_gave_up = 0;
+    xor_matrix_free(sat_state->xor_matrix);
+    card_set_free(sat_state->card_set);
+    elim_stack_free(sat_state->elim_stack);
+    sat_state->elim_stack = NULL;
+    sat_state->n_substituted = 0;
+    sat_state->n_hyper_binaries = 0;
+    sat_state->n_reduced_binaries = 0;
+    sat_state->n_backbone_gave_up = 0;
+    sat_state->vivifying = 0;
+    sat_state->current_level = 1;
+    sat_state->from_decision = 0;
+    sat_state->xor_matrix = xor_matrix_new(sat_state);
+    sat_state->card_set = card_set_new(sat_state);
+}
+
+//backjumps over more than threshold levels become chronological backtracks
+//(threshold 0, the default, disables chronological backtracking)
+void sat_set_chrono_threshold(c2dSize threshold, SatState* sat_state) {
+    sat_state->chrono_threshold = threshold;
 }
 
 /******************************************************************************
@@ -594,122 +988,235 @@ void sat_state_free(SatState* sat_state) {
  * Yet, the first decided literal must have 2 as its decision level
  ******************************************************************************/
 
-// uip 0 - unset, 1 - cannot reach, 2 - can reach, 3 - removed
-BOOLEAN uip_backtrack(Lit* cur, c2dSize* uip, c2dSize n, Lit* decide) {
-    if (uip[cur->index+n] == 3) return 0;
-    else if (cur == decide) return 1;
-    else if (uip[cur->index + n] == 2) return 1;
-    else if (uip[cur->index + n] == 1) return 0;
-    else {
-        Lit ** implied_by = cur->implied_by;
-        for (c2dSize i = 0; i < cur->n_implied_by; i ++) {
-            uip[cur->index + n] = 
-                uip_backtrack(implied_by[i], uip, n, decide) == 0 ? 1 : 2;
-            if (uip[cur->index + n] == 2) return 1;
-        }
-        return 0;
-    }
+/******************************************************************************
+ * Conflict analysis
+ *
+ * The conflict clause is resolved with the reasons of its literals of the
+ * conflict level, latest first along the trail, until a single literal of that
+ * level is left (the first UIP). Literals false at level 1 are dropped, since
+ * unit clauses imply them.
+ *
+ * Learned clauses met on the way are improved on the fly:
+ * --a reason whose literals (but the one resolved on) make up the resolvent is
+ *   strengthened by removing that literal, as the resolvent is implied
+ * --a reason (or the conflict clause) containing the final learned clause is
+ *   subsumed by it, and is removed
+ * Clauses of the cnf are left as they are, as c2D relies on them.
+ ******************************************************************************/
+
+//returns 1 if clause is a learned clause of sat state (not one that explains an
+//XOR or cardinality implication)
+static BOOLEAN is_learned(const Clause* clause, const SatState* sat_state) {
+    c2dSize m = sat_state->m;
+    return clause->index > m && clause->index <= m + sat_state->n_learned_clauses &&
+           sat_state->learned_clauses[clause->index - m - 1] == clause;
 }
 
-Lit * uip_find(Clause * clause, SatState * sat_state) {
-    Lit ** bfs_queue = malloc(sizeof(Lit*) * (2 * sat_state->n + 1));
-    BOOLEAN * checked = malloc(sizeof(BOOLEAN) * (2 * sat_state->n + 1));
-    for (c2dSize i = 0; i <= sat_state->n * 2; i ++) checked[i] = 0;
-    c2dSize front = 0;
-    c2dSize back = 0;
-    Lit ** lits = clause->literals;
-    Lit * conflict_lit = Lit_new(0);
-    conflict_lit->n_implied_by = clause->n_literals;
-    Lit ** clits = malloc(sizeof(Lit*) * clause->n_literals);
-    for (c2dSize i = 0; i < clause->n_literals; i ++) {
-        clits[i] = sat_index2literal(-lits[i]->index, sat_state);
-    }
-    conflict_lit->implied_by = clits;
-    bfs_queue[back++] = conflict_lit;
-    c2dSize * uip = malloc(sizeof(c2dSize) * (sat_state->n * 2 + 1));
-    while (front != back) {
-        for (c2dSize i = 0; i <= sat_state->n * 2; i ++) {
-            uip[i] = 0;
+static void detach_learned(Clause* clause, Lit* lit) {
+    for(c2dSize j = 0; j < lit->n_clauses; ++j)
+        if (lit->clauses[j] == clause) {
+            lit->clauses[j] = lit->clauses[--lit->n_clauses];
+            break;
         }
-        uip[bfs_queue[front]->index+sat_state->n] = 3;
-        if (bfs_queue[front] != conflict_lit &&
-            !uip_backtrack(conflict_lit, uip, sat_state->n, sat_state->decided_literals->literal)) {
-            Lit * res = bfs_queue[front];
-            free(bfs_queue);
-            free(checked);
-            Lit_delete(conflict_lit);
-            free(uip);
-            return res;
+}
+
+//removes lit (which clause implied) from learned clause, whose other literals are false
+static void strengthen_reason(Clause* clause, Lit* lit, SatState* sat_state) {
+    c2dSize size = clause->n_literals;
+    if (sat_state->proof) { //the shorter clause is added before the longer one is deleted
+        c2dLiteral* lits = malloc(sizeof(c2dLiteral) * size);
+        c2dSize k = 0;
+        for(c2dSize i = 0; i < size; ++i)
+            if (clause->literals[i] != lit) lits[k++] = clause->literals[i]->index;
+        lits[k] = lit->index;
+        proof_step(sat_state->proof, 'a', lits, size - 1);
+        proof_step(sat_state->proof, 'd', lits, size);
+        free(lits);
+    }
+    for(c2dSize i = 0; i < size; ++i)
+        if (clause->literals[i] == lit) {
+            clause->literals[i] = clause->literals[size - 1];
+            break;
         }
-        Lit ** lits = bfs_queue[front]->implied_by;
-        for (c2dSize i = 0; i < bfs_queue[front]->n_implied_by; i ++) {
-            if (checked[lits[i]->index+sat_state->n] == 0) {
-                bfs_queue[back++] = lits[i];
-                checked[lits[i]->index+sat_state->n] = 1;
-            }
+    clause->n_literals = size - 1;
+    detach_learned(clause, lit);
+    clause->subsumed_level = 0;
+    lit->reason = NULL;
+}
+
+//removes the learned clauses, closing the gaps they leave (renumbering the clauses)
+void remove_learned(Clause** clauses, c2dSize count, SatState* sat_state) {
+    c2dSize m = sat_state->m;
+    trail_forget(sat_state);
+    for(c2dSize c = 0; c < count; ++c) {
+        Clause* clause = clauses[c];
+        proof_clause_step(sat_state->proof, 'd', clause);
+        for(c2dSize i = 0; i < clause->n_literals; ++i) {
+            detach_learned(clause, clause->literals[i]);
+            if (clause->literals[i]->reason == clause) clause->literals[i]->reason = NULL;
         }
-        front ++;
+        sat_state->learned_clauses[clause->index - m - 1] = NULL;
+        Clause_delete(clause);
     }
-    free(bfs_queue);
-    free(checked);
-    Lit_delete(conflict_lit);
-    free(uip);
-    return NULL;
+    c2dSize kept = 0;
+    c2dSize vivified = 0;
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses; ++i) {
+        Clause* clause = sat_state->learned_clauses[i];
+        if (clause == NULL) continue;
+        if (i < sat_state->n_vivified) ++vivified;
+        clause->index = m + kept + 1;
+        sat_state->learned_clauses[kept++] = clause;
+    }
+    sat_state->n_learned_clauses = kept;
+    sat_state->n_vivified = vivified;
 }
 
-void backtrack(Lit* cur, Lit** marks, c2dSize highest_level, 
-        BOOLEAN* visited, c2dSize n, Lit * first_uip) {
-    if (visited[cur->index + n]) return;
-    visited[cur->index + n] = 1;
-    if (cur->decision_level < highest_level ||
-       (cur->decision_level == highest_level && cur->implied_by == NULL) || 
-        (cur == first_uip)) {
-        c2dSize id = cur->index + n;
-        marks[id] = cur;
-    } else {
-        for(c2dSize i = 0; i < cur->n_implied_by; ++i)
-            backtrack(cur->implied_by[i], marks, highest_level, visited, n, first_uip);
+//adds a clause with the given literals to the learned clauses, without running
+//unit resolution
+void append_learned(Lit** literals, c2dSize size, SatState* sat_state) {
+    if (sat_state->n_learned_clauses == sat_state->learned_clauses_buf_len) {
+        sat_state->learned_clauses_buf_len = sat_state->learned_clauses_buf_len ?
+            2 * sat_state->learned_clauses_buf_len : 1;
+        sat_state->learned_clauses = realloc(sat_state->learned_clauses,
+            sizeof(Clause*) * sat_state->learned_clauses_buf_len);
     }
-     
+    c2dSize index = sat_state->m + sat_state->n_learned_clauses + 1;
+    sat_state->learned_clauses[sat_state->n_learned_clauses++] =
+        Clause_new(index, literals, size, sat_state->m);
+}
+
+//sizes the conflict analysis arrays of sat state for its number of variables
+static void size_analysis(SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    if (sat_state->seen != NULL && sat_state->analysis_n == n) return;
+    ALLOC_GROWTH(4);
+    free(sat_state->seen);
+    sat_state->seen = calloc(2 * n + 1, sizeof(BOOLEAN));
+    sat_state->marked_lits = realloc(sat_state->marked_lits, sizeof(Lit*) * (n + 1));
+    sat_state->analysis_lits = realloc(sat_state->analysis_lits, sizeof(Lit*) * (n + 1));
+    sat_state->resolved = realloc(sat_state->resolved, sizeof(Clause*) * (n + 1));
+    sat_state->analysis_n = n;
+}
+
+//adds the false literal whose complement is lit to the clause being learned
+//(lit is marked in seen, and kept in marked_lits so that the mark can be cleared)
+static void analyze_literal(Lit* lit, c2dSize* count, c2dSize* n_marked, c2dSize* pending,
+                            c2dSize highest_level, SatState* sat_state) {
+    c2dSize id = lit->index + sat_state->n;
+    if (sat_state->seen[id] || lit->decision_level <= 1) return;
+    sat_state->seen[id] = 1;
+    sat_state->marked_lits[(*n_marked)++] = lit;
+    if (lit->decision_level == highest_level) ++*pending;
+    else sat_state->analysis_lits[(*count)++] = sat_index2literal(-lit->index, sat_state);
 }
 
 Clause* construct_asserted_clause(Clause* clause, SatState* sat_state) {
-    c2dSize highest_level = sat_state->current_level;
-    if (highest_level == 1) return NULL;
-    Lit** marks = malloc(sizeof(Lit*) * (sat_state->n * 2 + 1));
-    BOOLEAN* visited = malloc(sizeof(BOOLEAN) * (sat_state->n * 2 + 1));
-    for(c2dSize i = 0; i <= sat_state->n * 2; ++i) {
-        marks[i] = NULL;
-        visited[i] = 0;
-    }
-    // first_uip shouldn't be NULL here
-    Lit * first_uip = uip_find(clause, sat_state);
-    //Lit* first_uip = NULL;
-    for(c2dSize i = 0; i < clause->n_literals; ++i)
-        backtrack(sat_index2literal(-clause->literals[i]->index, sat_state),
-                  marks, highest_level, visited, sat_state->n, first_uip);
+    // the conflict is analyzed at its own level, which is below the current
+    // level when it involves literals implied out of order
+    c2dSize highest_level = 1;
+    for(c2dSize i = 0; i < clause->n_literals; ++i) {
+        Lit* lit = sat_index2literal(-clause->literals[i]->index, sat_state);
+        if (lit->decision_level > highest_level)
+            highest_level = lit->decision_level;
+    }
+    if (highest_level == 1) {
+        // contradiction without decisions: the cnf is unsatisfiable, and the
+        // empty clause (which has no assertion level) is learned
+        if (sat_state->empty_clause == NULL) {
+            sat_state->empty_clause = Clause_new(0, NULL, 0, sat_state->m);
+            sat_state->empty_clause->assertion_level = 0;
+        }
+        return sat_state->empty_clause;
+    }
+    c2dSize n = sat_state->n;
+    BOOLEAN otf = !sat_state->vivifying;
+    size_analysis(sat_state);
+    BOOLEAN* seen = sat_state->seen;
+    Lit** lits = sat_state->analysis_lits;
+    Clause** reasons = sat_state->resolved;
     c2dSize cnt = 0;
-    for(c2dSize i = 0; i <= sat_state->n * 2; ++i)
-        if (marks[i] != NULL)
-            ++cnt;
-    Lit** lits = malloc(sizeof(Lit*) * cnt);
-    cnt = 0;
-    c2dSize assertion_level = 1;
-    for(c2dSize i = 0; i <= sat_state->n * 2; ++i)
-        if (marks[i] != NULL) {
-            lits[cnt] = sat_index2literal(-marks[i]->index, sat_state);
-            ++cnt;
-            if (marks[i]->decision_level < highest_level &&
-                marks[i]->decision_level > assertion_level)
-                assertion_level = marks[i]->decision_level;
+    c2dSize n_marked = 0;
+    c2dSize pending = 0; //literals of the conflict level still to resolve
+    c2dSize n_reasons = 0;
+    for(c2dSize i = 0; i < clause->n_literals; ++i)
+        analyze_literal(sat_index2literal(-clause->literals[i]->index, sat_state),
+                        &cnt, &n_marked, &pending, highest_level, sat_state);
+    if (otf && is_learned(clause, sat_state)) reasons[n_reasons++] = clause;
+
+    Lit* uip = NULL;
+    LitNode* node = sat_state->implied_literals;
+    while (uip == NULL) {
+        while (node != NULL && (node->literal->decision_level != highest_level ||
+                                !seen[node->literal->index + n]))
+            node = node->prev;
+        if (node == NULL) { // only the decision of the conflict level is left
+            LitNode* decision = sat_state->decided_literals;
+            while (decision->literal->decision_level != highest_level)
+                decision = decision->prev;
+            uip = decision->literal;
+            break;
+        }
+        Lit* lit = node->literal;
+        node = node->prev;
+        if (pending == 1) {
+            uip = lit;
+            break;
+        }
+        --pending;
+        Clause* reason = lit->reason;
+        for(c2dSize i = 0; i < lit->n_implied_by; ++i)
+            analyze_literal(lit->implied_by[i], &cnt, &n_marked, &pending, highest_level, sat_state);
+        if (!otf || reason == NULL || !is_learned(reason, sat_state)) continue;
+        reasons[n_reasons++] = reason;
+        // the resolvent has cnt + pending literals, all of them in the reason
+        c2dSize size = 0;
+        for(c2dSize i = 0; i < reason->n_literals; ++i)
+            if (reason->literals[i] != lit &&
+                sat_index2literal(-reason->literals[i]->index, sat_state)->decision_level > 1)
+                ++size;
+        if (reason->n_literals > 2 && cnt + pending == size)
+            strengthen_reason(reason, lit, sat_state);
+    }
+    lits[cnt++] = sat_index2literal(-uip->index, sat_state);
+    for(c2dSize i = 0; i < n_marked; ++i) seen[sat_state->marked_lits[i]->index + n] = 0;
+
+    // learned clauses containing the new clause are subsumed by it
+    c2dSize n_subsumed = 0;
+    if (n_reasons > 0) {
+        for(c2dSize i = 0; i < cnt; ++i) seen[lits[i]->index + n] = 1;
+        for(c2dSize r = 0; r < n_reasons; ++r) {
+            c2dSize common = 0;
+            for(c2dSize i = 0; i < reasons[r]->n_literals; ++i)
+                common += seen[reasons[r]->literals[i]->index + n];
+            if (common == cnt) reasons[n_subsumed++] = reasons[r];
         }
+        for(c2dSize i = 0; i < cnt; ++i) seen[lits[i]->index + n] = 0;
+        if (n_subsumed > 0 && sat_state->proof) { //the new clause comes before the deletions
+            c2dLiteral* ids = malloc(sizeof(c2dLiteral) * cnt);
+            for(c2dSize i = 0; i < cnt; ++i) ids[i] = lits[i]->index;
+            proof_step(sat_state->proof, 'a', ids, cnt);
+            free(ids);
+        }
+        remove_learned(reasons, n_subsumed, sat_state);
+    }
+
+    c2dSize assertion_level = 1;
+    for(c2dSize i = 0; i + 1 < cnt; ++i) {
+        c2dSize level = sat_index2literal(-lits[i]->index, sat_state)->decision_level;
+        if (level > assertion_level) assertion_level = level;
+    }
+    Lit** literals = malloc(sizeof(Lit*) * cnt);
+    memcpy(literals, lits, sizeof(Lit*) * cnt);
     Clause* res = Clause_new(sat_clause_count(sat_state) + 
-        sat_learned_clause_count(sat_state) + 1, lits, cnt, sat_state->m);
+        sat_learned_clause_count(sat_state) + 1, literals, cnt, sat_state->m);
     res->assertion_level = cnt == 1 ? 1 : assertion_level;
-    free(marks);
-    free(visited);
+    // a long backjump is replaced by a chronological backtrack: the clause is
+    // asserted right below the conflict level, and the literal it implies is
+    // placed at its true level (the backjump level)
+    if (sat_state->chrono_threshold > 0 &&
+        highest_level - res->assertion_level > sat_state->chrono_threshold)
+        res->assertion_level = highest_level - 1;
     return res;
-    
 }
 
 
@@ -746,6 +1253,10 @@ Clause* unit_resolution_helper(Lit* cur, SatState* sat_state) {
     Lit * unset_lit = NULL;
     Clause * conflict_clause = NULL;
     //cur = sat_index2literal(-cur->index, sat_state);
+    if (sat_state->card_set != NULL) {
+        conflict_clause = card_propagate(sat_index2literal(-cur->index, sat_state), sat_state);
+        if (conflict_clause != NULL) return conflict_clause;
+    }
     for(c2dSize i = 0; i < cur->n_clauses; ++i) {
         Clause* clause = cur->clauses[i];
         if (sat_subsumed_clause(clause)) continue;
@@ -859,14 +1370,11 @@ BOOLEAN sat_unit_resolution(SatState* sat_state) {
    
     if (sat_state->from_decision) {
         sat_state->from_decision = 0;
-        Lit* unset_lit = sat_state->decided_literals->literal;
-        conflict_clause = unit_resolution_helper(
-            sat_index2literal(-sat_literal_index(unset_lit), sat_state),
-            sat_state);
+        conflict_clause = trail_replay(sat_state->decided_literals->literal, sat_state);
     } else {
         for (c2dSize i = 1; i <= sat_clause_count(sat_state) + sat_learned_clause_count(sat_state); ++i) {
             Clause * clause = sat_index2clause(i, sat_state);
-            if (sat_subsumed_clause(clause)) continue;
+            if (clause->detached || sat_subsumed_clause(clause)) continue;
             /*n_unset_lit = 0;
             n_false_lit = 0;
             Lit ** lits = sat_clause_literals(clause);
@@ -910,6 +1418,8 @@ BOOLEAN sat_unit_resolution(SatState* sat_state) {
             
         }
         }
+    if (conflict_clause == NULL && sat_state->xor_matrix != NULL)
+        conflict_clause = xor_propagate(sat_state);
     //unit_resolution_timer += clock() - t;
     //printf("unit:%ld\n",unit_resolution_timer);
     if (conflict_clause != NULL) {
@@ -926,34 +1436,9 @@ BOOLEAN sat_unit_resolution(SatState* sat_state) {
 //undoes sat_unit_resolution(), leading to un-instantiating variables that have been instantiated
 //after sat_unit_resolution()
 void sat_undo_unit_resolution(SatState* sat_state) {
-    LitNode* cur = sat_state->implied_literals;
-    while (cur != NULL) {
-        Lit* lit = cur->literal;
-        if (lit->decision_level == sat_state->current_level) {
-            lit->decision_level = 0;
-            lit->n_implied_by = 0;
-            if (lit->implied_by) free(lit->implied_by);
-            lit->implied_by = NULL;
-            
-            // clear all the subsumed clause
-            for (c2dSize i = 0; i < lit->n_clauses; i ++) {
-                Clause* clause = lit->clauses[i];
-                if (clause->subsumed_level == sat_state->current_level)
-                    clause->subsumed_level = 0;
-            }
-            modify_n_false(lit, sat_state, -1);
-            
-            LitNode* next = cur->next;
-            LitNode* prev = cur->prev;
-            if (prev != NULL) prev->next = next;
-            if (next != NULL) next->prev = prev;
-            if (next == NULL) sat_state->implied_literals = prev;
-            LitNode_delete(cur);
-            cur = prev;
-        } else {
-            cur = cur->prev;
-        }
-    }
+    //only the literals implied after the last decision can be at the current level
+    LitNode* stop = sat_state->decided_literals ? sat_state->decided_literals->trail : NULL;
+    undo_implied(sat_state->current_level - 1, stop, sat_state);
 }
 
 //returns 1 if the decision level of the sat state equals to the assertion level of clause,
@@ -0,0 +1,621 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Symmetry breaking
+ *
+ * The cnf is turned into a colored graph: a vertex per literal, a vertex per
+ * clause, an edge between each clause and its literals, and an edge between the
+ * two literals of each variable. Literals share a color and clauses are colored by
+ * size, so every automorphism of the graph maps literals to literals (keeping
+ * complementary literals complementary) and clauses to clauses: a symmetry of the
+ * cnf.
+ *
+ * Generators of the automorphism group are found by individualization and
+ * refinement (as in nauty or saucy):
+ * --a partition of the vertices is refined until it is equitable, that is,
+ *   vertices of a cell have as many neighbors as each other in every cell
+ * --the first path individualizes the first vertex of the first non-singleton
+ *   cell, refines, and repeats until every literal is in a cell of its own (the
+ *   leaf; clauses still sharing a cell are then identical)
+ * --at each level of the first path, from the deepest up, the other vertices w of
+ *   the cell are individualized instead; a path below w that ends in a leaf with
+ *   the same cells maps the first leaf to it, and the mapping is kept as a
+ *   generator if it is an automorphism
+ * --w is skipped when the generators found so far already map the vertex of the
+ *   first path to it
+ * The search gives up after SYM_MAX_WORK steps, keeping the generators found.
+ *
+ * Each generator g is broken by a lex-leader constraint, which keeps a model only
+ * if it is no greater than its image under g, reading variables x1 < x2 < ... of
+ * the support of g in order (false < true):
+ *   -e(j-1) or -xj or g(xj)                  (xj <= g(xj) if equal so far)
+ *   -e(j-1) or -xj or ej, -e(j-1) or g(xj) or ej  (equal up to xj)
+ * where e0 is true and e1, e2, ... are new variables. Every class of symmetric
+ * models keeps its least member, so satisfiability is preserved; the model count
+ * is not, which is why this is for sat solving only (not for c2D).
+ ******************************************************************************/
+
+#define SYM_MAX_WORK    20000000 //edges scanned by the automorphism search
+#define SYM_MAX_SUPPORT 100      //variables of a generator read by its lex-leader constraint
+
+typedef struct {
+    c2dSize n;          //2 vertices per variable (its literals), then 1 per clause
+    c2dSize* start;     //neighbors of v are adj[start[v]..start[v+1]-1]
+    c2dSize* adj;
+    c2dSize* color;
+} Graph;
+
+typedef struct {
+    Graph* graph;
+    //partition
+    c2dSize* lab;       //vertices, cell by cell
+    c2dSize* pos;       //position of each vertex in lab
+    c2dSize* cell;      //start (position) of the cell of each vertex
+    c2dSize* end;       //end of the cell starting at each position
+    //refinement
+    c2dSize* queue;     //cells (starts) to refine with, circular
+    c2dSize q_head;
+    c2dSize q_size;
+    BOOLEAN* queued;
+    c2dSize* count;     //neighbors of each vertex in the splitting cell
+    c2dSize* touched;
+    c2dSize* touched_cells;
+    BOOLEAN* cell_touched;
+    c2dSize* pairs;     //(count, vertex) of the cell being split
+    c2dSize work;
+    //first path
+    c2dSize depth;
+    c2dSize* path;      //vertex individualized at each level
+    c2dSize* target;    //start of its cell
+    c2dSize* level_of;  //level at which each cell start appears (n if never)
+    c2dSize* leaf;      //lab at the end of the first path
+    //search below another vertex
+    c2dSize* chosen;    //vertex individualized at each level
+    c2dSize* choice;    //rank of chosen among the candidates of its level
+    c2dSize* cands;
+    c2dSize* sigma;
+    c2dSize* stamp;
+    c2dSize* orbit;     //union-find over vertices
+    //generators: image of each positive literal
+    c2dLiteral** gens;
+    c2dSize n_gens;
+    c2dSize gens_buf_len;
+} Search;
+
+/******************************************************************************
+ * Graph
+ ******************************************************************************/
+
+static c2dSize lit_vertex(const Lit* lit) {
+    c2dSize v = 2 * (lit->var->index - 1);
+    return lit->index > 0 ? v : v + 1;
+}
+
+static c2dLiteral vertex_lit(c2dSize v) {
+    c2dLiteral x = (c2dLiteral)(v / 2 + 1);
+    return v % 2 ? -x : x;
+}
+
+static void graph_init(Graph* graph, const SatState* sat_state) {
+    c2dSize n = sat_state->n;
+    c2dSize m = sat_state->m;
+    graph->n = 2 * n + m;
+    graph->start = calloc(graph->n + 1, sizeof(c2dSize));
+    graph->color = malloc(sizeof(c2dSize) * graph->n);
+    c2dSize max_size = 0;
+    for(c2dSize i = 0; i < m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        if (clause->n_literals > max_size) max_size = clause->n_literals;
+        graph->color[2 * n + i] = clause->n_literals;
+        graph->start[2 * n + i + 1] += clause->n_literals;
+        for(c2dSize j = 0; j < clause->n_literals; ++j)
+            ++graph->start[lit_vertex(clause->literals[j]) + 1];
+    }
+    for(c2dSize x = 1; x <= n; ++x) {
+        Var* var = sat_index2var(x, sat_state);
+        c2dSize v = 2 * (x - 1);
+        if (var->n_clauses == 0) { //not in the cnf: a color of its own
+            graph->color[v] = max_size + 1 + v;
+            graph->color[v + 1] = max_size + 2 + v;
+        } else {
+            graph->color[v] = graph->color[v + 1] = 0;
+        }
+        ++graph->start[v + 1];
+        ++graph->start[v + 2];
+    }
+    for(c2dSize v = 0; v < graph->n; ++v) graph->start[v + 1] += graph->start[v];
+    graph->adj = malloc(sizeof(c2dSize) * (graph->start[graph->n] + 1));
+    c2dSize* fill = malloc(sizeof(c2dSize) * graph->n);
+    memcpy(fill, graph->start, sizeof(c2dSize) * graph->n);
+    for(c2dSize x = 1; x <= n; ++x) {
+        c2dSize v = 2 * (x - 1);
+        graph->adj[fill[v]++] = v + 1;
+        graph->adj[fill[v + 1]++] = v;
+    }
+    for(c2dSize i = 0; i < m; ++i) {
+        Clause* clause = sat_state->CNF_clauses[i];
+        for(c2dSize j = 0; j < clause->n_literals; ++j) {
+            c2dSize v = lit_vertex(clause->literals[j]);
+            graph->adj[fill[v]++] = 2 * n + i;
+            graph->adj[fill[2 * n + i]++] = v;
+        }
+    }
+    free(fill);
+}
+
+static void graph_free(Graph* graph) {
+    free(graph->start);
+    free(graph->adj);
+    free(graph->color);
+}
+
+/******************************************************************************
+ * Partition refinement
+ ******************************************************************************/
+
+static void enqueue(Search* s, c2dSize start) {
+    if (s->queued[start]) return;
+    s->queued[start] = 1;
+    s->queue[(s->q_head + s->q_size++) % s->graph->n] = start;
+}
+
+static int compare_pairs(const void* a, const void* b) {
+    const c2dSize* x = a;
+    const c2dSize* y = b;
+    return x[0] < y[0] ? -1 : (x[0] > y[0] ? 1 : (x[1] < y[1] ? -1 : x[1] > y[1]));
+}
+
+static int compare_starts(const void* a, const void* b) {
+    c2dSize x = *(const c2dSize*)a;
+    c2dSize y = *(const c2dSize*)b;
+    return x < y ? -1 : (x > y);
+}
+
+//splits the cell at start by the counts of its vertices
+static void split(Search* s, c2dSize start) {
+    c2dSize end = s->end[start];
+    c2dSize size = end - start;
+    for(c2dSize i = 0; i < size; ++i) {
+        c2dSize v = s->lab[start + i];
+        s->pairs[2 * i] = s->count[v];
+        s->pairs[2 * i + 1] = v;
+    }
+    qsort(s->pairs, size, 2 * sizeof(c2dSize), compare_pairs);
+    if (s->pairs[0] == s->pairs[2 * (size - 1)]) return; //all counts are equal
+
+    BOOLEAN was_queued = s->queued[start];
+    c2dSize largest = start;
+    c2dSize largest_size = 0;
+    c2dSize sub = start;
+    for(c2dSize i = 0; i < size; ++i) {
+        c2dSize v = s->pairs[2 * i + 1];
+        if (i > 0 && s->pairs[2 * i] != s->pairs[2 * (i - 1)]) {
+            s->end[sub] = start + i;
+            if (start + i - sub > largest_size) {
+                largest = sub;
+                largest_size = start + i - sub;
+            }
+            sub = start + i;
+        }
+        s->lab[start + i] = v;
+        s->pos[v] = start + i;
+        s->cell[v] = sub;
+    }
+    s->end[sub] = end;
+    if (end - sub > largest_size) largest = sub;
+
+    //all subcells are queued if the cell was, all but the largest otherwise
+    for(c2dSize p = start; p < end; p = s->end[p])
+        if (was_queued || p != largest) enqueue(s, p);
+}
+
+//refines the partition until it is equitable
+static void refine(Search* s) {
+    const Graph* graph = s->graph;
+    while (s->q_size > 0) {
+        c2dSize w = s->queue[s->q_head];
+        s->q_head = (s->q_head + 1) % graph->n;
+        --s->q_size;
+        s->queued[w] = 0;
+
+        c2dSize n_touched = 0;
+        c2dSize n_cells = 0;
+        for(c2dSize i = w; i < s->end[w]; ++i) {
+            c2dSize v = s->lab[i];
+            s->work += graph->start[v + 1] - graph->start[v];
+            for(c2dSize k = graph->start[v]; k < graph->start[v + 1]; ++k) {
+                c2dSize u = graph->adj[k];
+                if (s->count[u]++ == 0) s->touched[n_touched++] = u;
+                if (!s->cell_touched[s->cell[u]]) {
+                    s->cell_touched[s->cell[u]] = 1;
+                    s->touched_cells[n_cells++] = s->cell[u];
+                }
+            }
+        }
+        //cells are split in the order of their positions, so that isomorphic
+        //partitions are refined alike
+        qsort(s->touched_cells, n_cells, sizeof(c2dSize), compare_starts);
+        for(c2dSize i = 0; i < n_cells; ++i) {
+            c2dSize start = s->touched_cells[i];
+            s->cell_touched[start] = 0;
+            if (s->end[start] - start > 1) split(s, start);
+        }
+        for(c2dSize i = 0; i < n_touched; ++i) s->count[s->touched[i]] = 0;
+    }
+}
+
+//makes v a cell of its own, and refines
+static void individualize(Search* s, c2dSize v) {
+    c2dSize start = s->cell[v];
+    c2dSize end = s->end[start];
+    if (end - start > 1) {
+        c2dSize first = s->lab[start];
+        s->lab[s->pos[v]] = first;
+        s->pos[first] = s->pos[v];
+        s->lab[start] = v;
+        s->pos[v] = start;
+        s->end[start] = start + 1;
+        s->end[start + 1] = end;
+        for(c2dSize i = start + 1; i < end; ++i) s->cell[s->lab[i]] = start + 1;
+        if (s->queued[start]) enqueue(s, start + 1);
+        enqueue(s, start);
+    }
+    refine(s);
+}
+
+//sets the partition of the first path at a level: the cells of the leaf starting
+//at positions that appear at that level or before
+static void restore_level(Search* s, c2dSize level) {
+    c2dSize start = 0;
+    s->work += s->graph->n;
+    for(c2dSize p = 0; p < s->graph->n; ++p) {
+        if (s->level_of[p] <= level) {
+            if (p > 0) s->end[start] = p;
+            start = p;
+        }
+        s->lab[p] = s->leaf[p];
+        s->pos[s->leaf[p]] = p;
+        s->cell[s->leaf[p]] = start;
+    }
+    s->end[start] = s->graph->n;
+}
+
+//returns 1 if the cells of the partition are those of the first path at a level
+static BOOLEAN same_cells(Search* s, c2dSize level) {
+    s->work += s->graph->n;
+    for(c2dSize p = 0; p < s->graph->n; ++p)
+        if ((s->cell[s->lab[p]] == p) != (s->level_of[p] <= level)) return 0;
+    return 1;
+}
+
+/******************************************************************************
+ * Automorphisms
+ ******************************************************************************/
+
+static c2dSize find(c2dSize* orbit, c2dSize v) {
+    while (orbit[v] != v) v = orbit[v] = orbit[orbit[v]];
+    return v;
+}
+
+static BOOLEAN is_automorphism(Search* s) {
+    const Graph* graph = s->graph;
+    s->work += graph->start[graph->n];
+    for(c2dSize v = 0; v < graph->n; ++v) {
+        c2dSize image = s->sigma[v];
+        for(c2dSize k = graph->start[image]; k < graph->start[image + 1]; ++k)
+            s->stamp[graph->adj[k]] = v + 1;
+        for(c2dSize k = graph->start[v]; k < graph->start[v + 1]; ++k)
+            if (s->stamp[s->sigma[graph->adj[k]]] != v + 1) return 0;
+    }
+    return 1;
+}
+
+static void add_generator(Search* s, c2dSize n_vars) {
+    if (s->n_gens == s->gens_buf_len) {
+        s->gens_buf_len = s->gens_buf_len ? 2 * s->gens_buf_len : 16;
+        s->gens = realloc(s->gens, sizeof(c2dLiteral*) * s->gens_buf_len);
+    }
+    c2dLiteral* gen = malloc(sizeof(c2dLiteral) * (n_vars + 1));
+    for(c2dSize x = 1; x <= n_vars; ++x) gen[x] = vertex_lit(s->sigma[2 * (x - 1)]);
+    s->gens[s->n_gens++] = gen;
+    for(c2dSize v = 0; v < s->graph->n; ++v) {
+        c2dSize a = find(s->orbit, v);
+        c2dSize b = find(s->orbit, s->sigma[v]);
+        if (a != b) s->orbit[a] = b;
+    }
+}
+
+//the candidates of a level: the vertices of the cell of the first path, the
+//vertex of the first path first (so generators tend to move few vertices)
+static c2dSize candidates(Search* s, c2dSize level) {
+    c2dSize start = s->target[level];
+    c2dSize size = 0;
+    for(c2dSize p = start; p < s->end[start]; ++p) s->cands[size++] = s->lab[p];
+    qsort(s->cands, size, sizeof(c2dSize), compare_starts);
+    for(c2dSize i = 0; i < size; ++i)
+        if (s->cands[i] == s->path[level]) {
+            memmove(s->cands + 1, s->cands, sizeof(c2dSize) * i);
+            s->cands[0] = s->path[level];
+            break;
+        }
+    return size;
+}
+
+//sets the partition reached by individualizing the chosen vertices of levels
+//top..level-1 below the first path at level top
+static void replay(Search* s, c2dSize top, c2dSize level) {
+    restore_level(s, top);
+    for(c2dSize k = top; k < level; ++k) individualize(s, s->chosen[k]);
+}
+
+//looks for an automorphism mapping the first path to a path through w at level top
+//returns 1 if one is found (it is then in sigma)
+static BOOLEAN search_below(Search* s, c2dSize top, c2dSize w) {
+    c2dSize level = top;
+    s->choice[top] = 0;
+    restore_level(s, top);
+    while (s->work <= SYM_MAX_WORK) {
+        c2dSize n_cands = 1;
+        if (level > top) n_cands = candidates(s, level);
+        if (s->choice[level] >= n_cands) { //backtrack
+            if (level == top) return 0;
+            --level;
+            ++s->choice[level];
+            replay(s, top, level);
+            continue;
+        }
+        c2dSize u = level == top ? w : s->cands[s->choice[level]];
+        s->chosen[level] = u;
+        individualize(s, u);
+        BOOLEAN match = same_cells(s, level + 1);
+        if (match && level + 1 == s->depth) { //a leaf
+            for(c2dSize p = 0; p < s->graph->n; ++p) s->sigma[s->leaf[p]] = s->lab[p];
+            if (is_automorphism(s)) return 1;
+            match = 0;
+        }
+        if (!match) {
+            ++s->choice[level];
+            replay(s, top, level);
+            continue;
+        }
+        ++level;
+        s->choice[level] = 0;
+    }
+    return 0;
+}
+
+static void search_init(Search* s, Graph* graph) {
+    c2dSize n = graph->n;
+    memset(s, 0, sizeof(Search));
+    s->graph = graph;
+    s->lab = malloc(sizeof(c2dSize) * n);
+    s->pos = malloc(sizeof(c2dSize) * n);
+    s->cell = malloc(sizeof(c2dSize) * n);
+    s->end = malloc(sizeof(c2dSize) * n);
+    s->queue = malloc(sizeof(c2dSize) * n);
+    s->queued = calloc(n, sizeof(BOOLEAN));
+    s->count = calloc(n, sizeof(c2dSize));
+    s->touched = malloc(sizeof(c2dSize) * n);
+    s->touched_cells = malloc(sizeof(c2dSize) * n);
+    s->cell_touched = calloc(n, sizeof(BOOLEAN));
+    s->pairs = malloc(sizeof(c2dSize) * 2 * n);
+    s->path = malloc(sizeof(c2dSize) * n);
+    s->target = malloc(sizeof(c2dSize) * n);
+    s->level_of = malloc(sizeof(c2dSize) * n);
+    s->leaf = malloc(sizeof(c2dSize) * n);
+    s->chosen = malloc(sizeof(c2dSize) * n);
+    s->choice = malloc(sizeof(c2dSize) * (n + 1));
+    s->cands = malloc(sizeof(c2dSize) * n);
+    s->sigma = malloc(sizeof(c2dSize) * n);
+    s->stamp = calloc(n, sizeof(c2dSize));
+    s->orbit = malloc(sizeof(c2dSize) * n);
+    for(c2dSize v = 0; v < n; ++v) s->orbit[v] = v;
+}
+
+static void search_free(Search* s) {
+    free(s->lab);
+    free(s->pos);
+    free(s->cell);
+    free(s->end);
+    free(s->queue);
+    free(s->queued);
+    free(s->count);
+    free(s->touched);
+    free(s->touched_cells);
+    free(s->cell_touched);
+    free(s->pairs);
+    free(s->path);
+    free(s->target);
+    free(s->level_of);
+    free(s->leaf);
+    free(s->chosen);
+    free(s->choice);
+    free(s->cands);
+    free(s->sigma);
+    free(s->stamp);
+    free(s->orbit);
+    for(c2dSize i = 0; i < s->n_gens; ++i) free(s->gens[i]);
+    free(s->gens);
+}
+
+//finds generators of the automorphism group of the graph
+static void find_generators(Search* s, c2dSize n_vars) {
+    const Graph* graph = s->graph;
+    c2dSize n = graph->n;
+    if (n == 0) return;
+
+    //equitable partition refining the colors
+    for(c2dSize v = 0; v < n; ++v) {
+        s->pairs[2 * v] = graph->color[v];
+        s->pairs[2 * v + 1] = v;
+    }
+    qsort(s->pairs, n, 2 * sizeof(c2dSize), compare_pairs);
+    c2dSize start = 0;
+    for(c2dSize p = 0; p < n; ++p) {
+        if (p > 0 && s->pairs[2 * p] != s->pairs[2 * (p - 1)]) {
+            s->end[start] = p;
+            enqueue(s, start);
+            start = p;
+        }
+        s->lab[p] = s->pairs[2 * p + 1];
+        s->pos[s->lab[p]] = p;
+        s->cell[s->lab[p]] = start;
+    }
+    s->end[start] = n;
+    enqueue(s, start);
+    refine(s);
+
+    //first path
+    for(c2dSize p = 0; p < n; ++p) s->level_of[p] = s->cell[s->lab[p]] == p ? 0 : n;
+    c2dSize first = 0;
+    while (s->work <= SYM_MAX_WORK) {
+        while (first < n && s->end[first] - first == 1) first = s->end[first];
+        //literals come first, so the rest are cells of identical clauses
+        if (first == n || s->lab[first] >= 2 * n_vars) break;
+        s->path[s->depth] = s->lab[first];
+        s->target[s->depth] = first;
+        ++s->depth;
+        individualize(s, s->lab[first]);
+        for(c2dSize p = first; p < n; p = s->end[p])
+            if (s->level_of[p] == n) s->level_of[p] = s->depth;
+    }
+    if (s->work > SYM_MAX_WORK) return;
+    memcpy(s->leaf, s->lab, sizeof(c2dSize) * n);
+
+    //other paths, deepest level first
+    for(c2dSize level = s->depth; level-- > 0 && s->work <= SYM_MAX_WORK;) {
+        restore_level(s, level);
+        c2dSize start = s->target[level];
+        c2dSize end = s->end[start];
+        c2dSize* cell = malloc(sizeof(c2dSize) * (end - start));
+        memcpy(cell, s->leaf + start, sizeof(c2dSize) * (end - start));
+        c2dSize v = s->path[level];
+        for(c2dSize i = 0; i < end - start && s->work <= SYM_MAX_WORK; ++i) {
+            c2dSize w = cell[i];
+            if (find(s->orbit, w) == find(s->orbit, v)) continue;
+            if (search_below(s, level, w)) add_generator(s, n_vars);
+        }
+        free(cell);
+    }
+}
+
+/******************************************************************************
+ * Lex-leader constraints
+ ******************************************************************************/
+
+typedef struct {
+    c2dLiteral* data;   //each clause as its size followed by its literals
+    c2dSize size;
+    c2dSize buf_len;
+    c2dSize n_clauses;
+} ClauseBuf;
+
+static void buf_push(ClauseBuf* buf, c2dLiteral x) {
+    if (buf->size == buf->buf_len) {
+        buf->buf_len = buf->buf_len ? 2 * buf->buf_len : 256;
+        buf->data = realloc(buf->data, sizeof(c2dLiteral) * buf->buf_len);
+    }
+    buf->data[buf->size++] = x;
+}
+
+//adds the clause (-e or a or b), leaving out e when it is 0 and b when it is 0
+static void buf_clause(ClauseBuf* buf, c2dLiteral e, c2dLiteral a, c2dLiteral b) {
+    buf_push(buf, (e != 0) + 1 + (b != 0));
+    if (e != 0) buf_push(buf, -e);
+    buf_push(buf, a);
+    if (b != 0) buf_push(buf, b);
+    ++buf->n_clauses;
+}
+
+//adds the lex-leader constraint of generator gen, whose auxiliary variables are
+//numbered from *next_var
+static void lex_leader(const c2dLiteral* gen, c2dSize n_vars, c2dSize* next_var, ClauseBuf* buf) {
+    c2dLiteral e = 0; //equal so far (0: true)
+    c2dSize support = 0;
+    for(c2dSize x = 1; x <= n_vars && support < SYM_MAX_SUPPORT; ++x) {
+        c2dLiteral y = gen[x];
+        if (y == (c2dLiteral)x) continue;
+        ++support;
+        if (y == -(c2dLiteral)x) { //x <= -x: x is false, and equality is over
+            buf_clause(buf, e, -(c2dLiteral)x, 0);
+            return;
+        }
+        buf_clause(buf, e, -(c2dLiteral)x, y);
+        //the next equality variable is only needed by a later support variable
+        c2dSize later = x + 1;
+        while (later <= n_vars && gen[later] == (c2dLiteral)later) ++later;
+        if (later > n_vars || support == SYM_MAX_SUPPORT) return;
+        c2dLiteral next = (c2dLiteral)(*next_var)++;
+        buf_clause(buf, e, -(c2dLiteral)x, next);
+        buf_clause(buf, e, y, next);
+        e = next;
+    }
+}
+
+//adds variables n+1..new_n and the buffered clauses to the cnf of sat state
+static void extend_cnf(SatState* sat_state, c2dSize new_n, const ClauseBuf* buf) {
+    c2dSize n = sat_state->n;
+    xor_matrix_free(sat_state->xor_matrix);
+    card_set_free(sat_state->card_set);
+
+    extend_vars(new_n, sat_state);
+    sat_state->extended = 1;
+
+    //clauses are rebuilt, as cardinality constraints detach some of them
+    for(c2dSize i = 0; i < n; ++i) {
+        sat_state->variables[i]->n_clauses = 0;
+        sat_state->pos_literals[i]->n_clauses = 0;
+        sat_state->neg_literals[i]->n_clauses = 0;
+    }
+    c2dSize m = sat_state->m + buf->n_clauses;
+    trail_forget(sat_state);
+    sat_state->CNF_clauses = realloc(sat_state->CNF_clauses, sizeof(Clause*) * m);
+    for(c2dSize i = 0; i < sat_state->m; ++i) {
+        Clause* old = sat_state->CNF_clauses[i];
+        sat_state->CNF_clauses[i] = Clause_new(i + 1, old->literals, old->n_literals, m);
+        old->literals = NULL;
+        Clause_delete(old);
+    }
+    const c2dLiteral* data = buf->data;
+    for(c2dSize i = sat_state->m; i < m; ++i) {
+        c2dSize size = (c2dSize)*data++;
+        Lit** literals = malloc(sizeof(Lit*) * size);
+        for(c2dSize j = 0; j < size; ++j) literals[j] = sat_index2literal(*data++, sat_state);
+        sat_state->CNF_clauses[i] = Clause_new(i + 1, literals, size, m);
+    }
+    sat_state->m = m;
+    sat_state->xor_matrix = xor_matrix_new(sat_state);
+    sat_state->card_set = card_set_new(sat_state);
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//adds lex-leader constraints breaking the symmetries found in the cnf
+//returns the number of symmetry generators found
+c2dSize sat_break_symmetries(SatState* sat_state) {
+    assert(sat_state->current_level == 1 && sat_state->n_learned_clauses == 0);
+    c2dSize n = sat_state->n;
+    Graph graph;
+    graph_init(&graph, sat_state);
+    Search s;
+    search_init(&s, &graph);
+    find_generators(&s, n);
+
+    ClauseBuf buf;
+    memset(&buf, 0, sizeof(ClauseBuf));
+    c2dSize next_var = n + 1;
+    for(c2dSize i = 0; i < s.n_gens; ++i) lex_leader(s.gens[i], n, &next_var, &buf);
+    if (buf.n_clauses > 0) extend_cnf(sat_state, next_var - 1, &buf);
+
+    c2dSize n_gens = s.n_gens;
+    free(buf.data);
+    search_free(&s);
+    graph_free(&graph);
+    return n_gens;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,166 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Trail saving
+ *
+ * When decisions are undone, the literals they set are saved with their reasons,
+ * level by level: the decision of a level, then the literals implied at that
+ * level in trail order. The saved levels are kept on a stack, lowest level on
+ * top, so a backjump over several levels (one level at a time, or at once with
+ * sat_undo_to_level()) saves them all.
+ *
+ * When the decision on top is made again, the literals implied at its level are
+ * replayed: each one whose reason is still unit (its other literals are false)
+ * is implied right away, without searching the clauses for it. The replayed
+ * literals are then propagated as usual, so unit resolution stays complete; a
+ * saved literal which is now false, with a reason whose literals are all false,
+ * is a contradiction found without propagating at all.
+ *
+ * Any other decision drops the saved levels. So does removing a clause, since
+ * saved reasons must stay valid (see trail_forget()).
+ ******************************************************************************/
+
+typedef struct {
+    Lit* lit;
+    Clause* reason;         //NULL for a decision
+} SavedLit;
+
+struct saved_trail {
+    SavedLit* lits;         //the saved levels, lowest level on top
+    c2dSize size;
+    c2dSize buf_len;
+    c2dSize level;          //level of the decision on top
+    c2dSize n_replayed;     //literals implied from their saved reasons
+};
+
+SavedTrail* saved_trail_new(void) {
+    SavedTrail* trail = malloc(sizeof(SavedTrail));
+    trail->buf_len = 64;
+    trail->lits = malloc(sizeof(SavedLit) * trail->buf_len);
+    trail->size = 0;
+    trail->level = 0;
+    trail->n_replayed = 0;
+    return trail;
+}
+
+void saved_trail_free(SavedTrail* trail) {
+    if (trail) {
+        free(trail->lits);
+        free(trail);
+    }
+}
+
+static void push(SavedTrail* trail, Lit* lit, Clause* reason) {
+    if (trail->size == trail->buf_len) {
+        ALLOC_GROWTH(1);
+        trail->buf_len *= 2;
+        trail->lits = realloc(trail->lits, sizeof(SavedLit) * trail->buf_len);
+    }
+    trail->lits[trail->size].lit = lit;
+    trail->lits[trail->size].reason = reason;
+    ++trail->size;
+}
+
+//returns 1 if lit is a literal of clause, 0 otherwise
+static BOOLEAN in_clause(const Lit* lit, const Clause* clause) {
+    for(c2dSize i = 0; i < clause->n_literals; ++i)
+        if (clause->literals[i] == lit) return 1;
+    return 0;
+}
+
+//saves the decisions above level and the literals implied at their levels, before
+//they are undone
+void trail_save(c2dSize level, SatState* sat_state) {
+    SavedTrail* trail = sat_state->saved_trail;
+    if (trail == NULL || sat_state->vivifying) return;
+    //the saved levels must follow the ones undone now
+    if (trail->size > 0 && trail->level != sat_state->current_level + 1) trail->size = 0;
+
+    LitNode* node = sat_state->implied_literals;
+    for(LitNode* decision = sat_state->decided_literals;
+        decision != NULL && decision->literal->decision_level > level;
+        decision = decision->prev) {
+        //the implied literals come after the trail mark of their decision, and are
+        //pushed latest first (literals implied out of order are left out)
+        for( ; node != decision->trail; node = node->prev) {
+            Lit* lit = node->literal;
+            if (lit->decision_level == decision->literal->decision_level &&
+                lit->reason != NULL && lit->reason->index != 0) //not an XOR or cardinality reason
+                push(trail, lit, lit->reason);
+        }
+        push(trail, decision->literal, NULL);
+        trail->level = decision->literal->decision_level;
+    }
+}
+
+//replays the literals saved for the decision, which has just been made, and then
+//propagates the decision and the replayed literals
+//returns a clause whose literals are all false if a contradiction is found, NULL otherwise
+Clause* trail_replay(Lit* decision, SatState* sat_state) {
+    SavedTrail* trail = sat_state->saved_trail;
+    Lit* comp = sat_index2literal(-sat_literal_index(decision), sat_state);
+    if (trail == NULL || trail->size == 0) return unit_resolution_helper(comp, sat_state);
+    if (trail->lits[trail->size - 1].lit != decision ||
+        trail->level != sat_state->current_level) {
+        trail->size = 0;
+        return unit_resolution_helper(comp, sat_state);
+    }
+
+    //the saved level is popped: its literals stay in the buffer meanwhile, as
+    //nothing is saved during propagation
+    c2dSize end = --trail->size;
+    while (trail->size > 0 && trail->lits[trail->size - 1].reason != NULL) --trail->size;
+    c2dSize start = trail->size;
+    ++trail->level;
+
+    Clause* conflict = NULL;
+    for(c2dSize i = end; i > start && conflict == NULL; --i) {
+        SavedLit* saved = &trail->lits[i - 1];
+        Clause* reason = saved->reason;
+        Lit* lit = saved->lit;
+        saved->reason = NULL; //marks the literals not replayed
+        if (sat_implied_literal(lit) || !in_clause(lit, reason)) continue;
+        if (sat_implied_literal(sat_index2literal(-sat_literal_index(lit), sat_state))) {
+            if (reason->n_false == reason->n_literals) conflict = reason;
+        } else if (reason->n_false == reason->n_literals - 1) { //the other literals are false
+            imply_literal(lit, reason, sat_state);
+            saved->reason = reason;
+            ++trail->n_replayed;
+        }
+    }
+    if (conflict == NULL) conflict = unit_resolution_helper(comp, sat_state);
+    for(c2dSize i = end; i > start && conflict == NULL; --i) {
+        SavedLit* saved = &trail->lits[i - 1];
+        if (saved->reason != NULL)
+            conflict = unit_resolution_helper(sat_index2literal(-sat_literal_index(saved->lit),
+                sat_state), sat_state);
+    }
+    return conflict;
+}
+
+//drops the saved levels (their reasons may be about to be freed)
+void trail_forget(SatState* sat_state) {
+    if (sat_state->saved_trail) sat_state->saved_trail->size = 0;
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//turns trail saving on (enable 1) or off (enable 0)
+void sat_set_trail_saving(BOOLEAN enable, SatState* sat_state) {
+    if (enable && sat_state->saved_trail == NULL) sat_state->saved_trail = saved_trail_new();
+    else if (!enable) {
+        saved_trail_free(sat_state->saved_trail);
+        sat_state->saved_trail = NULL;
+    }
+}
+
+//returns the number of literals implied from their saved reasons
+c2dSize sat_replayed_literal_count(const SatState* sat_state) {
+    return sat_state->saved_trail ? sat_state->saved_trail->n_replayed : 0;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,164 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * Vivification of learned clauses
+ *
+ * A learned clause C = (l1 or ... or lk) is taken out of the literal lists, and
+ * the negations of its literals are decided one at a time (levels 2, 3, ...):
+ * --if li is already false, it is dropped from C
+ * --if li is implied by the decisions on -l1..-l(i-1), then C is implied by the
+ *   other clauses and is removed
+ * --if deciding -li leads to a contradiction, C is shortened to the literals
+ *   seen so far (l1..li, without the dropped ones)
+ * --if li is already true at level 1, C is shortened to li
+ *
+ * Every shortened clause is implied by the cnf and subsumes C, so the models do
+ * not change. Vivification runs at decision level 1 only, after unit resolution,
+ * and the decisions it makes are undone before it returns.
+ *
+ * The clauses learned since the last vivification are candidates, shortest
+ * first, up to VIVIFY_MAX_CLAUSES of them.
+ ******************************************************************************/
+
+#define VIVIFY_MAX_CLAUSES 200 //clauses vivified per call
+
+//removes clause from the clause lists of its literals
+static void detach(Clause* clause) {
+    for(c2dSize i = 0; i < clause->n_literals; ++i) {
+        Lit* lit = clause->literals[i];
+        for(c2dSize j = 0; j < lit->n_clauses; ++j)
+            if (lit->clauses[j] == clause) {
+                lit->clauses[j] = lit->clauses[--lit->n_clauses];
+                break;
+            }
+    }
+}
+
+//frees a clause learned from a contradiction reached while vivifying
+static void discard(Clause* learned, SatState* sat_state) {
+    sat_state->asserted_clause = NULL;
+    if (learned == sat_state->empty_clause) return;
+    detach(learned);
+    Clause_delete(learned);
+}
+
+//vivifies the detached clause, keeping the literals to retain in lits
+//returns the number of literals kept, or 0 if the clause is to be removed
+static c2dSize vivify_clause(const Clause* clause, Lit** lits, SatState* sat_state) {
+    c2dSize size = 0;
+    BOOLEAN removed = 0;
+    for(c2dSize i = 0; i < clause->n_literals; ++i) {
+        Lit* lit = clause->literals[i];
+        if (sat_implied_literal(lit)) {
+            if (lit->decision_level > 1) removed = 1;
+            else {
+                lits[0] = lit;
+                size = 1;
+            }
+            break;
+        }
+        if (sat_implied_literal(sat_literal_complement(lit))) continue;
+        lits[size++] = lit;
+        Clause* learned = sat_decide_literal(sat_literal_complement(lit), sat_state);
+        if (learned != NULL) {
+            sat_undo_decide_literal(sat_state);
+            discard(learned, sat_state);
+            break;
+        }
+    }
+    sat_undo_to_level(1, sat_state);
+    return removed ? 0 : size;
+}
+
+static int compare_sizes(const void* a, const void* b) {
+    c2dSize x = (*(Clause* const*)a)->n_literals;
+    c2dSize y = (*(Clause* const*)b)->n_literals;
+    return x < y ? -1 : (x > y);
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//vivifies the clauses learned since the last call, shortening or removing them
+//returns 0 if the cnf is found to be unsatisfiable, 1 otherwise
+BOOLEAN sat_vivify(SatState* sat_state) {
+    assert(sat_state->current_level == 1);
+    c2dSize m = sat_state->m;
+    c2dSize first = sat_state->n_vivified;
+    c2dSize count = sat_state->n_learned_clauses - first;
+    sat_state->n_vivified = sat_state->n_learned_clauses;
+    if (count == 0) return 1;
+    trail_forget(sat_state); //the candidates are freed
+
+    Clause** candidates = malloc(sizeof(Clause*) * count);
+    c2dSize n_candidates = 0;
+    for(c2dSize i = first; i < sat_state->n_learned_clauses; ++i) {
+        Clause* clause = sat_state->learned_clauses[i];
+        if (clause->n_literals > 1 && !sat_subsumed_clause(clause))
+            candidates[n_candidates++] = clause;
+    }
+    qsort(candidates, n_candidates, sizeof(Clause*), compare_sizes);
+    if (n_candidates > VIVIFY_MAX_CLAUSES) n_candidates = VIVIFY_MAX_CLAUSES;
+
+    //phases are saved when decisions are undone, and vivifying must not change them
+    BOOLEAN* phases = malloc(sizeof(BOOLEAN) * (sat_state->n + 1));
+    for(c2dSize i = 1; i <= sat_state->n; ++i) phases[i] = sat_index2var(i, sat_state)->phase;
+
+    //conflict analysis must not strengthen or remove the candidates meanwhile
+    sat_state->vivifying = 1;
+    BOOLEAN new_units = 0;
+    for(c2dSize c = 0; c < n_candidates; ++c) {
+        Clause* clause = candidates[c];
+        c2dSize position = clause->index - m - 1;
+        Lit** lits = malloc(sizeof(Lit*) * clause->n_literals);
+        detach(clause);
+        c2dSize size = vivify_clause(clause, lits, sat_state);
+        if (size == clause->n_literals) { //unchanged: reattached as a new clause
+            free(lits);
+            Clause* same = Clause_new(clause->index, clause->literals, clause->n_literals, m);
+            clause->literals = NULL;
+            Clause_delete(clause);
+            clause = same;
+        } else if (size == 0) { //removed
+            free(lits);
+            proof_clause_step(sat_state->proof, 'd', clause);
+            Clause_delete(clause);
+            clause = NULL;
+        } else {
+            Clause* shorter = Clause_new(clause->index, lits, size, m);
+            proof_clause_step(sat_state->proof, 'a', shorter);
+            proof_clause_step(sat_state->proof, 'd', clause);
+            Clause_delete(clause);
+            clause = shorter;
+            new_units |= size == 1;
+        }
+        sat_state->learned_clauses[position] = clause;
+    }
+    sat_state->vivifying = 0;
+    for(c2dSize i = 1; i <= sat_state->n; ++i) sat_index2var(i, sat_state)->phase = phases[i];
+    free(phases);
+    free(candidates);
+
+    //the removed clauses leave gaps, which are closed (renumbering the clauses)
+    c2dSize kept = 0;
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses; ++i) {
+        Clause* clause = sat_state->learned_clauses[i];
+        if (clause == NULL) continue;
+        clause->index = m + kept + 1;
+        sat_state->learned_clauses[kept++] = clause;
+    }
+    sat_state->n_learned_clauses = kept;
+    sat_state->n_vivified = kept;
+    return new_units ? sat_unit_resolution(sat_state) : 1;
+}
+
+//vivifies the learned clauses whenever interval more clauses have been learned
+//(interval 0, the default, disables vivification)
+void sat_set_vivify_interval(c2dSize interval, SatState* sat_state) {
+    sat_state->vivify_interval = interval;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,139 @@
+#include <stdint.h>
+#include "sat_api.h"
+
+/******************************************************************************
+ * Saving and loading learned clauses
+ *
+ * The short learned clauses of a sat state are saved to a binary file, so that a
+ * later sat state for the same cnf starts with them instead of learning them again.
+ * The file holds, as 32-bit integers in the byte order of the machine:
+ * --LEARNED_MAGIC, then the hash of the formula (see formula_hash()) as two
+ *   halves, the number of variables and the number of clauses
+ * --each clause: its size, then its literals
+ *
+ * Learned clauses follow from the formula, so loading them changes no model (nor
+ * model count). A file is loaded only into a sat state whose formula has the same
+ * hash, and a clause only when each of its variables is still mentioned by a cnf
+ * clause: a variable that sat_simplify() dropped is free in the simplified cnf, and
+ * a clause over it would constrain it.
+ *
+ * Nothing is saved from a sat state whose cnf has clauses that do not follow from
+ * its formula (symmetry breaking, sat_add_clause()), as its learned clauses may
+ * depend on them.
+ ******************************************************************************/
+
+#define LEARNED_MAGIC 0x314e524cU //"LRN1"
+
+static BOOLEAN write_word(uint32_t word, FILE* fp) {
+    return fwrite(&word, sizeof(uint32_t), 1, fp) == 1;
+}
+
+static BOOLEAN read_word(uint32_t* word, FILE* fp) {
+    return fread(word, sizeof(uint32_t), 1, fp) == 1;
+}
+
+//returns 1 if the learned clause is worth saving: it has at most max_size literals,
+//and (unless it is a unit clause) it is not satisfied at level 1
+static BOOLEAN saved(const Clause* clause, c2dSize max_size) {
+    if (clause->n_literals > max_size) return 0;
+    if (clause->n_literals == 1) return 1;
+    for(c2dSize i = 0; i < clause->n_literals; ++i) {
+        Lit* lit = clause->literals[i];
+        if (sat_implied_literal(lit) && lit->decision_level == 1) return 0;
+    }
+    return 1;
+}
+
+//returns 1 if each variable of the clause is mentioned by a cnf clause of sat
+//state, 0 otherwise (or if the clause mentions no variable of sat state)
+static BOOLEAN loadable(const int32_t* lits, c2dSize size, const SatState* sat_state) {
+    for(c2dSize i = 0; i < size; ++i) {
+        c2dSize index = (c2dSize)(lits[i] > 0 ? lits[i] : -(c2dLiteral)lits[i]);
+        if (index == 0 || index > sat_state->n) return 0;
+        if (sat_state->variables[index - 1]->n_clauses == 0) return 0;
+    }
+    return 1;
+}
+
+/******************************************************************************
+ * API
+ ******************************************************************************/
+
+//saves the learned clauses of sat state with at most max_size literals to the file
+//returns the number of clauses saved
+c2dSize sat_save_learned_clauses(const char* file_name, c2dSize max_size, const SatState* sat_state) {
+    if (sat_state->extended || sat_state->n > INT32_MAX) return 0;
+    c2dSize count = 0;
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses; ++i)
+        count += saved(sat_state->learned_clauses[i], max_size);
+    if (count > UINT32_MAX) return 0;
+
+    FILE* fp = fopen(file_name, "wb");
+    if (fp == NULL) {
+        printf("Error: file %s cannot be open", file_name);
+        return 0;
+    }
+    Formula* formula = formula_of_state(sat_state);
+    unsigned long long hash = formula_hash(formula);
+    formula_release(formula);
+    BOOLEAN ok = write_word(LEARNED_MAGIC, fp) &&
+                 write_word((uint32_t)hash, fp) && write_word((uint32_t)(hash >> 32), fp) &&
+                 write_word((uint32_t)sat_state->n, fp) && write_word((uint32_t)count, fp);
+    for(c2dSize i = 0; i < sat_state->n_learned_clauses && ok; ++i) {
+        const Clause* clause = sat_state->learned_clauses[i];
+        if (!saved(clause, max_size)) continue;
+        ok = write_word((uint32_t)clause->n_literals, fp);
+        for(c2dSize j = 0; j < clause->n_literals && ok; ++j)
+            ok = write_word((uint32_t)(int32_t)clause->literals[j]->index, fp);
+    }
+    if (fclose(fp) != 0) ok = 0;
+    return ok ? count : 0;
+}
+
+//adds the clauses saved to the file to the learned clauses of sat state, if they
+//were saved for its formula, and runs unit resolution
+//returns 0 if unit resolution finds a contradiction, 1 otherwise
+BOOLEAN sat_load_learned_clauses(const char* file_name, SatState* sat_state) {
+    assert(sat_state->current_level == 1 && sat_state->proof == NULL);
+    FILE* fp = fopen(file_name, "rb");
+    if (fp == NULL) return 1; //nothing saved yet
+
+    Formula* formula = formula_of_state(sat_state);
+    unsigned long long hash = formula_hash(formula);
+    c2dSize formula_n = formula_var_count(formula);
+    formula_release(formula);
+    uint32_t magic, hash_low, hash_high, n, count;
+    if (!read_word(&magic, fp) || !read_word(&hash_low, fp) || !read_word(&hash_high, fp) ||
+        !read_word(&n, fp) || !read_word(&count, fp) || magic != LEARNED_MAGIC ||
+        hash_low != (uint32_t)hash || hash_high != (uint32_t)(hash >> 32) ||
+        n != formula_n) {
+        fclose(fp);
+        return 1;
+    }
+
+    c2dSize n_added = 0;
+    int32_t* lits = malloc(sizeof(int32_t) * (n + 1));
+    for(uint32_t i = 0; i < count; ++i) {
+        uint32_t size;
+        if (!read_word(&size, fp) || size == 0 || size > n ||
+            fread(lits, sizeof(int32_t), size, fp) != size) break;
+        if (!loadable(lits, size, sat_state)) continue;
+        Lit** literals = malloc(sizeof(Lit*) * size);
+        for(c2dSize j = 0; j < size; ++j) literals[j] = sat_index2literal(lits[j], sat_state);
+        append_learned(literals, size, sat_state);
+        ++n_added;
+    }
+    free(lits);
+    fclose(fp);
+    if (n_added == 0) return 1;
+    //the implications are undone, as after probing: counting and compiling start
+    //with unit resolution of their own, which would not find a contradiction left
+    //in place (the clauses of cardinality constraints are not visited)
+    BOOLEAN consistent = sat_unit_resolution(sat_state);
+    sat_undo_unit_resolution(sat_state);
+    return consistent;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
@@ -0,0 +1,393 @@
+#include "sat_api.h"
+
+/******************************************************************************
+ * XOR constraints and Gauss-Jordan propagation
+ *
+ * Parity chains (such as the par instances) encode each constraint
+ * x1 + ... + xk = rhs (mod 2) as the 2^(k-1) clauses that forbid the assignments
+ * of the wrong parity. Unit resolution only sees these clauses one at a time,
+ * so it misses most of what the constraints imply together.
+ *
+ * When a sat state is constructed, clauses with the same k variables (k small)
+ * are grouped, and every complete group of clauses is recovered as an XOR
+ * constraint. The constraints form a matrix over GF(2), with one packed bit-row
+ * per constraint and one column per variable, so that adding two rows is a
+ * word-parallel XOR.
+ *
+ * After unit resolution reaches a fixpoint, the matrix is reduced by
+ * Gauss-Jordan elimination, choosing pivots among the free variables only.
+ * The reduced matrix is kept between calls: when the free columns change, a row
+ * whose pivot is no longer free gives it up, and only the rows without a pivot
+ * are reduced again (a call is skipped altogether when no column changed since
+ * the last fixpoint). Each reduced row is a constraint implied by the cnf:
+ * --a row with no free variable whose parity is wrong is a conflict
+ * --a row with a single free variable implies its value
+ * The clause explaining such a conflict or implication consists of the literals
+ * of the row's variables that are false in the current setting (together with
+ * the implied literal), which is exactly what unit resolution and
+ * construct_asserted_clause() expect from a clause.
+ ******************************************************************************/
+
+#define XOR_MAX_SIZE 5  //largest constraint recovered from clauses
+#define WORD_BITS    (8*sizeof(XorWord))
+
+typedef unsigned long XorWord;
+
+struct xor_matrix {
+    c2dSize n_rows;
+    c2dSize n_cols;
+    c2dSize n_words;    //words per row
+    c2dSize* col2var;   //variable index of each column
+    XorWord* rows;      //the recovered constraints, n_rows*n_words
+    BOOLEAN* rhs;
+    XorWord* work;      //the reduced matrix
+    BOOLEAN* work_rhs;
+    long* pivot;        //pivot column of each reduced row, -1 if it has none
+    XorWord* free;      //bit of each column whose variable is free
+    XorWord* value;     //bit of each column whose variable is true
+    BOOLEAN settled;    //whether the last call reached a fixpoint without a clause
+    Lit** literals;     //literals of the explaining clause
+    Clause reason;      //explaining clause (not part of the sat state)
+};
+
+/******************************************************************************
+ * Recovering XOR constraints from clauses
+ ******************************************************************************/
+
+typedef struct {
+    c2dSize vars[XOR_MAX_SIZE]; //sorted variable indices
+    c2dSize size;
+    unsigned sign;              //bit j is set if the literal of vars[j] is negative
+} XorCandidate;
+
+static int compare_candidates(const void* a, const void* b) {
+    const XorCandidate* x = a;
+    const XorCandidate* y = b;
+    if (x->size != y->size) return x->size < y->size ? -1 : 1;
+    for(c2dSize j = 0; j < x->size; ++j)
+        if (x->vars[j] != y->vars[j]) return x->vars[j] < y->vars[j] ? -1 : 1;
+    return 0;
+}
+
+//fills a candidate for a clause, returns 0 if the clause cannot be part of a group
+static BOOLEAN make_candidate(Clause* clause, XorCandidate* cand) {
+    c2dSize k = clause->n_literals;
+    if (k < 2 || k > XOR_MAX_SIZE) return 0;
+    cand->size = k;
+    for(c2dSize j = 0; j < k; ++j) {
+        //insertion sort by variable index
+        Lit* lit = clause->literals[j];
+        c2dSize i = j;
+        while (i > 0 && cand->vars[i - 1] > lit->var->index) {
+            cand->vars[i] = cand->vars[i - 1];
+            --i;
+        }
+        if (i > 0 && cand->vars[i - 1] == lit->var->index) return 0;
+        cand->vars[i] = lit->var->index;
+    }
+    cand->sign = 0;
+    for(c2dSize j = 0; j < k; ++j) {
+        Lit* lit = clause->literals[j];
+        if (lit->index > 0) continue;
+        for(c2dSize i = 0; i < k; ++i)
+            if (cand->vars[i] == lit->var->index) cand->sign |= 1u << i;
+    }
+    return 1;
+}
+
+static int odd(unsigned bits) {
+    return __builtin_popcount(bits) & 1;
+}
+
+//a group of clauses over the same k variables encodes x1 + ... + xk = rhs when
+//it forbids all 2^(k-1) assignments of parity 1-rhs (a clause forbids the
+//assignment that sets its negative literals' variables to 1)
+static c2dSize find_xors(XorCandidate* cands, c2dSize n_cands, XorCandidate* xors,
+                         BOOLEAN* rhs) {
+    c2dSize n_xors = 0;
+    for(c2dSize first = 0, last; first < n_cands; first = last) {
+        last = first + 1;
+        while (last < n_cands && compare_candidates(&cands[first], &cands[last]) == 0)
+            ++last;
+        c2dSize k = cands[first].size;
+        unsigned long seen[2] = {0, 0}; //forbidden assignments of each parity
+        for(c2dSize i = first; i < last; ++i)
+            seen[odd(cands[i].sign)] |= 1UL << cands[i].sign;
+        for(int parity = 0; parity < 2; ++parity) {
+            if (__builtin_popcountl(seen[parity]) != (1 << (k - 1))) continue;
+            xors[n_xors] = cands[first];
+            rhs[n_xors++] = !parity;
+        }
+    }
+    return n_xors;
+}
+
+//recovers the XOR constraints of the cnf of sat state
+//returns NULL if there are none
+XorMatrix* xor_matrix_new(SatState* sat_state) {
+    if (sat_state->proof != NULL) return NULL; //its clauses could not be checked
+    XorCandidate* cands = malloc(sizeof(XorCandidate) * (sat_state->m + 1));
+    c2dSize n_cands = 0;
+    for(c2dSize i = 0; i < sat_state->m; ++i)
+        if (make_candidate(sat_state->CNF_clauses[i], &cands[n_cands])) ++n_cands;
+    qsort(cands, n_cands, sizeof(XorCandidate), compare_candidates);
+
+    XorCandidate* xors = malloc(sizeof(XorCandidate) * (n_cands + 1));
+    BOOLEAN* rhs = malloc(sizeof(BOOLEAN) * (n_cands + 1));
+    c2dSize n_xors = find_xors(cands, n_cands, xors, rhs);
+    free(cands);
+
+    //equivalences (k=2) are handled well by unit resolution: they are kept only
+    //when they share variables with longer constraints (so the matrix can chain them)
+    c2dSize* var2col = calloc(sat_state->n + 1, sizeof(c2dSize));
+    for(c2dSize r = 0; r < n_xors; ++r)
+        if (xors[r].size > 2)
+            for(c2dSize j = 0; j < xors[r].size; ++j) var2col[xors[r].vars[j]] = 1;
+    c2dSize kept = 0;
+    for(c2dSize r = 0; r < n_xors; ++r) {
+        if (xors[r].size == 2 && !var2col[xors[r].vars[0]] && !var2col[xors[r].vars[1]])
+            continue;
+        xors[kept] = xors[r];
+        rhs[kept++] = rhs[r];
+    }
+    n_xors = kept;
+    memset(var2col, 0, sizeof(c2dSize) * (sat_state->n + 1));
+    if (n_xors == 0) {
+        free(var2col);
+        free(xors);
+        free(rhs);
+        return NULL;
+    }
+
+    //columns for the variables mentioned by the constraints
+    XorMatrix* matrix = malloc(sizeof(XorMatrix));
+    matrix->col2var = malloc(sizeof(c2dSize) * sat_state->n);
+    matrix->n_cols = 0;
+    for(c2dSize r = 0; r < n_xors; ++r)
+        for(c2dSize j = 0; j < xors[r].size; ++j) {
+            c2dSize v = xors[r].vars[j];
+            if (var2col[v] == 0) {
+                matrix->col2var[matrix->n_cols++] = v;
+                var2col[v] = matrix->n_cols;
+            }
+        }
+
+    c2dSize words = (matrix->n_cols + WORD_BITS - 1) / WORD_BITS;
+    matrix->n_rows   = n_xors;
+    matrix->n_words  = words;
+    matrix->rows     = calloc(n_xors * words, sizeof(XorWord));
+    matrix->rhs      = rhs;
+    matrix->work     = malloc(sizeof(XorWord) * n_xors * words);
+    matrix->work_rhs = malloc(sizeof(BOOLEAN) * n_xors);
+    matrix->pivot    = malloc(sizeof(long) * n_xors);
+    matrix->free     = calloc(words, sizeof(XorWord));
+    matrix->value    = calloc(words, sizeof(XorWord));
+    matrix->settled  = 0;
+    matrix->literals = malloc(sizeof(Lit*) * matrix->n_cols);
+    for(c2dSize r = 0; r < n_xors; ++r)
+        for(c2dSize j = 0; j < xors[r].size; ++j) {
+            c2dSize c = var2col[xors[r].vars[j]] - 1;
+            matrix->rows[r * words + c / WORD_BITS] |= 1UL << (c % WORD_BITS);
+        }
+    //no column is free yet, so the matrix is reduced as it is
+    memcpy(matrix->work, matrix->rows, sizeof(XorWord) * n_xors * words);
+    memcpy(matrix->work_rhs, rhs, sizeof(BOOLEAN) * n_xors);
+    for(c2dSize r = 0; r < n_xors; ++r) matrix->pivot[r] = -1;
+    memset(&matrix->reason, 0, sizeof(Clause));
+    matrix->reason.literals = matrix->literals;
+    matrix->reason.assertion_level = 1;
+
+    free(var2col);
+    free(xors);
+    return matrix;
+}
+
+void xor_matrix_free(XorMatrix* matrix) {
+    if (matrix) {
+        free(matrix->col2var);
+        free(matrix->rows);
+        free(matrix->rhs);
+        free(matrix->work);
+        free(matrix->work_rhs);
+        free(matrix->pivot);
+        free(matrix->free);
+        free(matrix->value);
+        free(matrix->literals);
+        free(matrix);
+    }
+}
+
+//returns a copy of the matrix (for a clone of its sat state)
+XorMatrix* xor_matrix_clone(const XorMatrix* matrix) {
+    if (matrix == NULL) return NULL;
+    c2dSize cells = matrix->n_rows * matrix->n_words;
+    XorMatrix* copy = malloc(sizeof(XorMatrix));
+    *copy = *matrix;
+    copy->col2var  = malloc(sizeof(c2dSize) * matrix->n_cols);
+    copy->rows     = malloc(sizeof(XorWord) * cells);
+    copy->rhs      = malloc(sizeof(BOOLEAN) * matrix->n_rows);
+    copy->work     = malloc(sizeof(XorWord) * cells);
+    copy->work_rhs = malloc(sizeof(BOOLEAN) * matrix->n_rows);
+    copy->pivot    = malloc(sizeof(long) * matrix->n_rows);
+    copy->free     = malloc(sizeof(XorWord) * matrix->n_words);
+    copy->value    = malloc(sizeof(XorWord) * matrix->n_words);
+    copy->literals = malloc(sizeof(Lit*) * matrix->n_cols);
+    memcpy(copy->col2var, matrix->col2var, sizeof(c2dSize) * matrix->n_cols);
+    memcpy(copy->rows, matrix->rows, sizeof(XorWord) * cells);
+    memcpy(copy->rhs, matrix->rhs, sizeof(BOOLEAN) * matrix->n_rows);
+    //the reduced matrix goes with the setting it was reduced for
+    memcpy(copy->work, matrix->work, sizeof(XorWord) * cells);
+    memcpy(copy->work_rhs, matrix->work_rhs, sizeof(BOOLEAN) * matrix->n_rows);
+    memcpy(copy->pivot, matrix->pivot, sizeof(long) * matrix->n_rows);
+    memcpy(copy->free, matrix->free, sizeof(XorWord) * matrix->n_words);
+    memcpy(copy->value, matrix->value, sizeof(XorWord) * matrix->n_words);
+    copy->reason.literals = copy->literals;
+    copy->reason.n_literals = 0;
+    return copy;
+}
+
+//returns the number of XOR constraints recovered from the cnf
+c2dSize sat_xor_count(const SatState* sat_state) {
+    return sat_state->xor_matrix ? sat_state->xor_matrix->n_rows : 0;
+}
+
+/******************************************************************************
+ * Gauss-Jordan propagation
+ ******************************************************************************/
+
+static BOOLEAN test_bit(const XorWord* row, c2dSize c) {
+    return (row[c / WORD_BITS] >> (c % WORD_BITS)) & 1;
+}
+
+//captures which columns are free and which are true in the current setting
+//returns 1 if any of them changed since the last call (and sets *free_changed
+//if the free columns did)
+static BOOLEAN read_setting(XorMatrix* matrix, BOOLEAN* free_changed, SatState* sat_state) {
+    BOOLEAN value_changed = 0;
+    *free_changed = 0;
+    for(c2dSize w = 0; w < matrix->n_words; ++w) {
+        XorWord free = 0;
+        XorWord value = 0;
+        c2dSize last = (w + 1) * WORD_BITS < matrix->n_cols ? (w + 1) * WORD_BITS : matrix->n_cols;
+        for(c2dSize c = w * WORD_BITS; c < last; ++c) {
+            Var* var = sat_index2var(matrix->col2var[c], sat_state);
+            XorWord bit = 1UL << (c % WORD_BITS);
+            if (!sat_instantiated_var(var)) free |= bit;
+            else if (sat_implied_literal(var->pos_literal)) value |= bit;
+        }
+        if (free != matrix->free[w]) *free_changed = 1;
+        if (value != matrix->value[w]) value_changed = 1;
+        matrix->free[w] = free;
+        matrix->value[w] = value;
+    }
+    return *free_changed || value_changed;
+}
+
+//brings the reduced matrix up to date with the free columns, choosing pivots
+//among free columns only: a row whose pivot is no longer free gives it up, and
+//each row without a pivot takes one of its free columns (if any) and clears it
+//from the other rows
+//
+//rows keep a free column only if it is their pivot or no other row pivots on it,
+//so the result is the one a reduction from scratch would give (up to the pivots)
+static void eliminate(XorMatrix* matrix) {
+    c2dSize words = matrix->n_words;
+    for(c2dSize r = 0; r < matrix->n_rows; ++r)
+        if (matrix->pivot[r] >= 0 && !test_bit(matrix->free, matrix->pivot[r]))
+            matrix->pivot[r] = -1;
+    for(c2dSize r = 0; r < matrix->n_rows; ++r) {
+        if (matrix->pivot[r] >= 0) continue;
+        XorWord* row = matrix->work + r * words;
+        c2dSize w = 0;
+        while (w < words && (row[w] & matrix->free[w]) == 0) ++w;
+        if (w == words) continue; //no free column: nothing to pivot on
+        c2dSize c = w * WORD_BITS + __builtin_ctzl(row[w] & matrix->free[w]);
+        matrix->pivot[r] = c;
+        for(c2dSize s = 0; s < matrix->n_rows; ++s) {
+            XorWord* other = matrix->work + s * words;
+            if (s == r || !test_bit(other, c)) continue;
+            for(c2dSize i = 0; i < words; ++i) other[i] ^= row[i];
+            matrix->work_rhs[s] ^= matrix->work_rhs[r];
+        }
+    }
+}
+
+//fills the explaining clause of a row: the false literals of its instantiated
+//variables, and the literal implied for its free column (if any)
+static Clause* explain(XorMatrix* matrix, const XorWord* row, Lit* implied,
+                       SatState* sat_state) {
+    c2dSize n = 0;
+    if (implied) matrix->literals[n++] = implied;
+    for(c2dSize c = 0; c < matrix->n_cols; ++c) {
+        if (!test_bit(row, c) || test_bit(matrix->free, c)) continue;
+        Var* var = sat_index2var(matrix->col2var[c], sat_state);
+        matrix->literals[n++] = test_bit(matrix->value, c) ? var->neg_literal
+                                                          : var->pos_literal;
+    }
+    matrix->reason.n_literals = n;
+    return &matrix->reason;
+}
+
+//returns the free column of a row if it is the only one, -1 if there are none,
+//and -2 if there are more
+static long single_free_column(XorMatrix* matrix, const XorWord* row) {
+    long col = -1;
+    for(c2dSize w = 0; w < matrix->n_words; ++w) {
+        XorWord bits = row[w] & matrix->free[w];
+        if (bits == 0) continue;
+        if (col != -1 || (bits & (bits - 1))) return -2;
+        col = w * WORD_BITS + __builtin_ctzl(bits);
+    }
+    return col;
+}
+
+static BOOLEAN row_parity(XorMatrix* matrix, const XorWord* row) {
+    c2dSize ones = 0;
+    for(c2dSize w = 0; w < matrix->n_words; ++w)
+        ones += __builtin_popcountl(row[w] & matrix->value[w] & ~matrix->free[w]);
+    return ones & 1;
+}
+
+//runs Gauss-Jordan propagation (interleaved with unit resolution) to a fixpoint
+//returns a clause whose literals are all false if a contradiction is found, NULL otherwise
+Clause* xor_propagate(SatState* sat_state) {
+    XorMatrix* matrix = sat_state->xor_matrix;
+    BOOLEAN free_changed;
+    if (!read_setting(matrix, &free_changed, sat_state) && matrix->settled) return NULL;
+    matrix->settled = 0;
+    BOOLEAN changed = 1;
+    while (changed) {
+        changed = 0;
+        if (free_changed) eliminate(matrix);
+        for(c2dSize r = 0; r < matrix->n_rows; ++r) {
+            const XorWord* row = matrix->work + r * matrix->n_words;
+            long c = single_free_column(matrix, row);
+            if (c == -2) continue;
+            BOOLEAN value = matrix->work_rhs[r] ^ row_parity(matrix, row);
+            if (c == -1) {
+                if (value) return explain(matrix, row, NULL, sat_state); //contradiction
+                continue;
+            }
+            Var* var = sat_index2var(matrix->col2var[c], sat_state);
+            Lit* lit = value ? var->pos_literal : var->neg_literal;
+            if (sat_implied_literal(lit)) continue; //implied by an earlier row
+            if (sat_instantiated_var(var)) {
+                //the opposite value was implied by an earlier row
+                return explain(matrix, row, lit, sat_state);
+            }
+            Clause* reason = explain(matrix, row, lit, sat_state);
+            imply_literal(lit, reason, sat_state);
+            Clause* conflict = unit_resolution_helper(
+                sat_index2literal(-lit->index, sat_state), sat_state);
+            if (conflict != NULL) return conflict;
+            changed = 1;
+        }
+        if (changed) read_setting(matrix, &free_changed, sat_state);
+    }
+    matrix->settled = 1;
+    return NULL;
+}
+
+/******************************************************************************
+ * end
+ ******************************************************************************/
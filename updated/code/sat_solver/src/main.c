@@ -1,10 +1,25 @@
 #include "sat_api.h"
 
 /******************************************************************************
- * SAT solver 
+ * SAT solver
  ******************************************************************************/
 
-//returns a literal which is free in the current setting of sat state  
+//budgets of the first round when alternating local search and CDCL
+//(both budgets are doubled after each round)
+#define ROUND_FLIPS     100000
+#define ROUND_CONFLICTS 100
+
+//flips allowed when local search runs on its own
+#define MAX_FLIPS 100000000
+
+//number of clauses CDCL may learn before restarting (0 means no limit)
+static c2dSize conflict_budget = 0;
+//set when CDCL gives up because its budget is exhausted
+static BOOLEAN restarted = 0;
+//whether learned clauses are vivified (also at each restart)
+static BOOLEAN vivify = 0;
+
+//returns a literal which is free in the current setting of sat state
 //a NAIVE implementation no one would use in practice
 //you are free to modify this (no need though)
 Lit* get_free_literal(SatState* sat_state) {
@@ -13,16 +28,21 @@ Lit* get_free_literal(SatState* sat_state) {
     Var* var  = sat_index2var(i+1,sat_state); //note index is i+1, not i
     Lit* plit = sat_pos_literal(var);
     Lit* nlit = sat_neg_literal(var);
-    if(!sat_implied_literal(plit) && !sat_implied_literal(nlit)) return plit;
+    if(!sat_implied_literal(plit) && !sat_implied_literal(nlit)) return sat_phase_literal(var);
   }
   return NULL; //all literals are implied
 }
 
-//if sat state is shown to be satisfiable, it returns NULL
+//if sat state is shown to be satisfiable, it returns NULL (and the model is saved)
 //otherwise, a clause must be learned and it is returned
+//
+//NULL is also returned when the conflict budget runs out (restarted is then set)
 Clause* sat_aux(SatState* sat_state) {
   Lit* lit = get_free_literal(sat_state);
-  if(lit==NULL) return NULL; //all literals are implied
+  if(lit==NULL) { //all literals are implied
+    sat_save_model(sat_state);
+    return NULL;
+  }
 
   Clause* learned = sat_decide_literal(lit,sat_state);
   if(learned==NULL) learned = sat_aux(sat_state);
@@ -31,7 +51,13 @@ Clause* sat_aux(SatState* sat_state) {
   if(learned!=NULL) { //there is a conflict
     if(sat_at_assertion_level(learned,sat_state)) {
       learned = sat_assert_clause(learned,sat_state);
-      if(learned==NULL) return sat_aux(sat_state); //try again
+      if(learned==NULL) {
+        if(conflict_budget!=0 && --conflict_budget==0) { //restart
+          restarted = 1;
+          return NULL;
+        }
+        return sat_aux(sat_state); //try again
+      }
       else return learned; //new clause learned, backtrack
     }
     else return learned; //backtrack (still conflict)
@@ -46,20 +72,149 @@ BOOLEAN sat(SatState* sat_state) {
   return ret;
 }
 
-int main(int argc, char* argv[]) {	
-  char USAGE_MSG[] = "Usage: ./sat -c <cnf_file>\n";
+//alternates rounds of local search and CDCL until one of them decides the cnf
+//local search starts from the phases saved by CDCL and leaves its best assignment
+//as the phases CDCL decides on; learned clauses are kept across rounds
+BOOLEAN sat_alternating(SatState* sat_state) {
+  c2dSize flips     = ROUND_FLIPS;
+  c2dSize conflicts = ROUND_CONFLICTS;
+  BOOLEAN ret       = 0;
+  for(unsigned long round=1; ; round++) {
+    if(!sat_unit_resolution(sat_state)) break; //unsatisfiable
+    if(round>1 && vivify && !sat_vivify(sat_state)) break; //unsatisfiable
+    if(sat_local_search(flips,round,sat_state)) {
+      ret = 1;
+      break;
+    }
+    conflict_budget = conflicts;
+    restarted       = 0;
+    Clause* learned = sat_aux(sat_state);
+    if(!restarted) {
+      ret = (learned==NULL? 1: 0);
+      break;
+    }
+    sat_undo_unit_resolution(sat_state);
+    flips     *= 2;
+    conflicts *= 2;
+  }
+  sat_undo_unit_resolution(sat_state);
+  conflict_budget = 0;
+  return ret;
+}
+
+//returns 1 if local search finds a model, 0 if unit resolution shows the cnf is
+//unsatisfiable, and -1 otherwise
+int sat_local(SatState* sat_state) {
+  int ret = 0;
+  if(sat_unit_resolution(sat_state)) ret = (sat_local_search(MAX_FLIPS,1,sat_state)? 1: -1);
+  sat_undo_unit_resolution(sat_state);
+  return ret;
+}
+
+//prints the model in DIMACS format (over the first var_count variables)
+void print_model(c2dSize var_count, SatState* sat_state) {
+  printf("v");
+  for(c2dSize i=1; i<=var_count; i++) {
+    Lit* plit = sat_pos_literal(sat_index2var(i,sat_state));
+    printf(" %ld",sat_model_literal(plit,sat_state)? (long)i: -(long)i);
+  }
+  printf(" 0\n");
+}
+
+int main(int argc, char* argv[]) {
+  char USAGE_MSG[] = "Usage: ./sat -c <cnf_file> [-l | -a] [-b <levels>] [-n] [-r] [-p | -k] [-q <conflicts>] [-s] [-V <learned>] [-t] [-d <proof_file>] [-v]\n"
+                     "  -l  use local search only\n"
+                     "  -a  alternate local search and CDCL\n"
+                     "  -b  backtrack chronologically instead of backjumping over more\n"
+                     "      than <levels> decision levels (default 0: always backjump)\n"
+                     "  -n  do not preprocess the cnf\n"
+                     "  -r  re-encode products of clauses (such as pairwise at-most-one\n"
+                     "      constraints) with new variables by bounded variable addition\n"
+                     "  -p  probe for failed literals before search\n"
+                     "  -k  probe, and then find the backbone literals\n"
+                     "  -q  give up a backbone query of -k after <conflicts> learned clauses,\n"
+                     "      leaving its literal out of the backbone (default 2, 0: never)\n"
+                     "  -s  break symmetries of the cnf before search\n"
+                     "  -V  vivify the learned clauses each time <learned> more are learned\n"
+                     "      and at each restart (default 0: never)\n"
+                     "  -t  save the literals undone by backjumps, and replay them when their\n"
+                     "      decisions are made again\n"
+                     "  -d  write a binary DRAT proof to <proof_file> (not with -k, -r or -s)\n"
+                     "  -v  print a model when the cnf is satisfiable\n";
   char* cnf_fname  = NULL;
+  char mode        = 0;
+  c2dSize chrono   = 0;
+  c2dSize interval = 0;
+  BOOLEAN simplify = 1;
+  BOOLEAN reencode = 0;
+  char probe       = 0;
+  c2dSize conflicts = BACKBONE_MAX_CONFLICTS;
+  BOOLEAN symmetry = 0;
+  BOOLEAN trail    = 0;
+  char* proof_fname = NULL;
+  BOOLEAN verbose  = 0;
 
-  if(argc==3 && strcmp("-c",argv[1])==0) cnf_fname = argv[2];
-  else {
+  for(int i=1; i<argc; i++) {
+    if(strcmp("-c",argv[i])==0 && i+1<argc) cnf_fname = argv[++i];
+    else if(strcmp("-l",argv[i])==0 || strcmp("-a",argv[i])==0) mode = argv[i][1];
+    else if(strcmp("-b",argv[i])==0 && i+1<argc) chrono = strtoul(argv[++i],NULL,10);
+    else if(strcmp("-V",argv[i])==0 && i+1<argc) interval = strtoul(argv[++i],NULL,10);
+    else if(strcmp("-q",argv[i])==0 && i+1<argc) conflicts = strtoul(argv[++i],NULL,10);
+    else if(strcmp("-d",argv[i])==0 && i+1<argc) proof_fname = argv[++i];
+    else if(strcmp("-n",argv[i])==0) simplify = 0;
+    else if(strcmp("-r",argv[i])==0) reencode = 1;
+    else if(strcmp("-p",argv[i])==0 || strcmp("-k",argv[i])==0) probe = argv[i][1];
+    else if(strcmp("-s",argv[i])==0) symmetry = 1;
+    else if(strcmp("-t",argv[i])==0) trail = 1;
+    else if(strcmp("-v",argv[i])==0) verbose = 1;
+    else {
+      cnf_fname = NULL;
+      break;
+    }
+  }
+  if(proof_fname!=NULL && (probe=='k' || reencode || symmetry)) cnf_fname = NULL; //their clauses are not logged
+  if(cnf_fname==NULL) {
     printf("%s",USAGE_MSG);
     exit(1);
   }
-	
+
   //construct a sat state and then check satisfiability
   SatState* sat_state = sat_state_new(cnf_fname);
-  if(sat(sat_state)) printf("SAT\n");
-  else printf("UNSAT\n");
+  if(proof_fname!=NULL && !sat_proof_open(proof_fname,sat_state)) {
+    printf("Cannot open %s\n",proof_fname);
+    exit(1);
+  }
+  sat_set_chrono_threshold(chrono,sat_state);
+  sat_set_vivify_interval(interval,sat_state);
+  sat_set_trail_saving(trail,sat_state);
+  sat_set_backbone_conflicts(conflicts,sat_state);
+  vivify = interval>0;
+  c2dSize var_count = sat_var_count(sat_state); //symmetry breaking and -r add variables
+  int ret;
+  if(simplify && !sat_preprocess(sat_state)) ret = 0;
+  else {
+    if(reencode) printf("Added variables %lu\n",sat_add_bounded_variables(sat_state));
+    if(symmetry) sat_break_symmetries(sat_state);
+    if(probe && !sat_probe(probe=='k',sat_state)) ret = 0;
+    else if(mode=='l') ret = sat_local(sat_state);
+    else if(mode=='a') ret = sat_alternating(sat_state);
+    else               ret = sat(sat_state);
+  }
+#ifdef SAT_ALLOC_CHECK
+  sat_print_alloc_stats();
+#endif
+  if(probe) printf("Hyper-binary clauses %lu (%lu learned binary clauses removed)\n",
+                  sat_hyper_binary_count(sat_state),sat_reduced_binary_count(sat_state));
+  if(probe=='k') printf("Backbone candidates given up %lu\n",sat_backbone_gave_up_count(sat_state));
+  if(trail) printf("Replayed literals %lu\n",sat_replayed_literal_count(sat_state));
+  if(ret==1) {
+    sat_extend_model(sat_state); //to the variables eliminated by preprocessing
+    printf("SAT\n");
+    if(verbose) print_model(var_count,sat_state);
+  }
+  else if(ret==0) printf("UNSAT\n");
+  else printf("UNKNOWN\n");
+  sat_proof_close(ret==0,sat_state);
   sat_state_free(sat_state);
 
   return 0;
@@ -1,7 +1,7 @@
 #!/bin/bash
 
 OUTPUT_FOLDER="test_result"
-TEST_FILES=./benchmarks/sampled/*
+TEST_FILES="./benchmarks/sampled/* ./benchmarks/regression/*"
 TIMEOUT="5s"
 
 rm -f $OUTPUT_FOLDER/*.out
@@ -13,12 +13,43 @@ cp primitives/libsat.a c2D_code/lib/darwin/
 (cd c2D_code/ && make clean)
 (cd c2D_code/ && make)
 
+#prints the model count found in a c2D output file (nothing if it timed out)
+count_of() {
+	grep -E "^ +Count[[:space:]]+[0-9]" $1 | awk '{print $2}'
+}
+
+#prints the model count stated by a "c count" line of a cnf file (nothing if none)
+stated_count_of() {
+	grep -E "^c count " $1 | awk '{print $3}'
+}
+
+MISMATCHES=0
 for f in $TEST_FILES
 do
 	filename="$(basename "$f")"
 	echo "Testing $filename file..."
 	gtimeout $TIMEOUT executables/c2D/darwin/c2D -c $f -W > $OUTPUT_FOLDER/$filename.out
 	gtimeout $TIMEOUT c2D_code/bin/darwin/c2D -c $f -W > $OUTPUT_FOLDER/my_$filename.out
+	expected="$(count_of $OUTPUT_FOLDER/$filename.out)"
+	[ -z "$expected" ] && expected="$(stated_count_of $f)"
+	[ -z "$expected" ] && continue
+
+	#each option must keep the count of the reference binary (-L runs twice: the
+	#first run saves the learned clauses, the second one starts from them)
+	learned="$OUTPUT_FOLDER/$filename.learned"
+	rm -f $learned
+	OPTIONS=("" "-K -B 1" "-P" "-F" "-F -K" "-K -Q 0" "-V 100" "-T" "-L $learned" "-L $learned" "-H 0" "-H 2")
+	for i in "${!OPTIONS[@]}"
+	do
+		out="$OUTPUT_FOLDER/my_$filename.$i.out"
+		gtimeout $TIMEOUT c2D_code/bin/darwin/c2D -c $f -W ${OPTIONS[$i]} > $out
+		count="$(count_of $out)"
+		if [ -n "$count" ] && [ "$count" != "$expected" ]; then
+			echo "  MISMATCH with ${OPTIONS[$i]}: $count (expected $expected)"
+			MISMATCHES=$((MISMATCHES+1))
+		fi
+	done
 done
+echo "$MISMATCHES mismatches"
 
 